@@ -0,0 +1,74 @@
+// Adaptive tapping term, see adaptive_tapping.h.
+
+#include "adaptive_tapping.h"
+
+#include <string.h>
+
+typedef struct {
+    uint16_t samples[ADAPTIVE_TAPPING_SAMPLES];
+    uint8_t  next;
+    uint8_t  count;
+    uint16_t press_time;
+    bool     pressed;
+    bool     lonely;  // no other key pressed since this press
+} tap_history_t;
+
+static tap_history_t history[TAP_SLOT_COUNT];
+
+static void add_sample(tap_history_t *h, uint16_t duration) {
+    h->samples[h->next] = duration;
+    h->next             = (h->next + 1) % ADAPTIVE_TAPPING_SAMPLES;
+    if (h->count < ADAPTIVE_TAPPING_SAMPLES) {
+        h->count++;
+    }
+}
+
+void adaptive_tapping_press(uint8_t slot, uint16_t time) {
+    if (slot >= TAP_SLOT_COUNT) return;
+    history[slot].press_time = time;
+    history[slot].pressed    = true;
+    history[slot].lonely     = true;
+}
+
+void adaptive_tapping_other_key(void) {
+    for (uint8_t i = 0; i < TAP_SLOT_COUNT; i++) {
+        history[i].lonely = false;
+    }
+}
+
+void adaptive_tapping_release(uint8_t slot, uint16_t time, bool tapped, uint16_t configured_term) {
+    if (slot >= TAP_SLOT_COUNT || !history[slot].pressed) return;
+    tap_history_t *h        = &history[slot];
+    uint16_t       duration = time - h->press_time;
+    h->pressed              = false;
+
+    // A hold released on its own shortly after the configured term was a tap that
+    // came in too slow for the shrunk window. A longer lone hold (Ctrl held over a
+    // mouse click) or anything chorded with another key was a real hold.
+    bool missed_tap = h->lonely && (uint32_t)duration <= (uint32_t)configured_term + ADAPTIVE_TAPPING_MARGIN;
+    if (tapped || missed_tap) {
+        add_sample(h, duration);
+    }
+}
+
+uint16_t adaptive_tapping_term(uint8_t slot, uint16_t configured_term) {
+    if (slot >= TAP_SLOT_COUNT || history[slot].count < ADAPTIVE_TAPPING_MIN_SAMPLES) {
+        return configured_term;
+    }
+    const tap_history_t *h       = &history[slot];
+    uint16_t             longest = 0;
+    for (uint8_t i = 0; i < h->count; i++) {
+        if (h->samples[i] > longest) {
+            longest = h->samples[i];
+        }
+    }
+
+    uint32_t term = (uint32_t)longest + ADAPTIVE_TAPPING_MARGIN;
+    if (term < ADAPTIVE_TAPPING_MIN) term = ADAPTIVE_TAPPING_MIN;
+    if (term > configured_term) term = configured_term;
+    return (uint16_t)term;
+}
+
+void adaptive_tapping_reset(void) {
+    memset(history, 0, sizeof(history));
+}
@@ -0,0 +1,48 @@
+// Adaptive tapping term for dual-role keys.
+//
+// Each tracked key keeps a small ring of recent "meant as a tap" press durations
+// and its decision window shrinks to the longest of them plus a safety margin,
+// never beyond the key's configured term. A press held past a shrunk window that
+// produced nothing (released without any other key) and let go by the configured
+// term plus the margin counts as a missed tap and grows the window back; a longer
+// lone hold (Ctrl + mouse click) was a real hold and is not learned.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef ADAPTIVE_TAPPING_SAMPLES
+#    define ADAPTIVE_TAPPING_SAMPLES 8      // ring size per key
+#endif
+#ifndef ADAPTIVE_TAPPING_MIN_SAMPLES
+#    define ADAPTIVE_TAPPING_MIN_SAMPLES 4  // keep the configured term until this many
+#endif
+#ifndef ADAPTIVE_TAPPING_MARGIN
+#    define ADAPTIVE_TAPPING_MARGIN 40      // ms added to the longest recent tap
+#endif
+#ifndef ADAPTIVE_TAPPING_MIN
+#    define ADAPTIVE_TAPPING_MIN 120        // ms, lower bound for any adapted term
+#endif
+
+enum adaptive_tapping_slot {
+    TAP_SLOT_ESC_CTRL,  // MT(MOD_LCTL, KC_ESC)
+    TAP_SLOT_ENT_CTRL,  // MT(MOD_RCTL, KC_ENT)
+    TAP_SLOT_GRV_VIM,   // LT(_VIM, KC_GRV)
+    TAP_SLOT_COUNT
+};
+
+// Press of the tracked key (record->event.time of the press).
+void adaptive_tapping_press(uint8_t slot, uint16_t time);
+
+// Any other key was pressed; presses of tracked keys in progress are no longer lonely.
+void adaptive_tapping_other_key(void);
+
+// Release of the tracked key. `tapped` is record->tap.count > 0; `configured_term`
+// is the key's term before adaptation.
+void adaptive_tapping_release(uint8_t slot, uint16_t time, bool tapped, uint16_t configured_term);
+
+// Decision window for the slot, at most `configured_term`.
+uint16_t adaptive_tapping_term(uint8_t slot, uint16_t configured_term);
+
+void adaptive_tapping_reset(void);
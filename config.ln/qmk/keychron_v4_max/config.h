@@ -3,20 +3,55 @@
 #pragma once
 
 // Tapping configuration
-#define TAPPING_TERM 200                    // Time in ms for tap vs hold
+#define TAPPING_TERM 200                    // Time in ms for tap vs hold (keys without their own term)
+#define TAPPING_TERM_PER_KEY                // Per-key terms below, see get_tapping_term() in keymap.c
+#define TAPPING_TERM_ESC_CTRL 175           // Caps Lock: Esc / Left Ctrl
+#define TAPPING_TERM_ENT_CTRL 175           // Enter: Enter / Right Ctrl
+#define TAPPING_TERM_GRV_VIM 200            // Physical Esc: ` / VIM layer
+#define ADAPTIVE_TAPPING_TERM               // Shrink the three terms above to match recent taps (comment out to disable)
 #define PERMISSIVE_HOLD                     // Makes tap and hold more reliable
+#define TYPING_STREAK_INTERVAL 200          // Typing faster than this (ms/key) makes the keys above plain taps...
+#define TYPING_STREAK_QUIET 250             // ...until this long without typing (typing_streak.h)
 // IGNORE_MOD_TAP_INTERRUPT removed - now default behavior in modern QMK
 
+// Debounce (debounce_asym.h): presses register on the first edge
+#define DEBOUNCE 5                          // ms a release must stay open; also the hold-off after it
+#define DEBOUNCE_CHATTER_WINDOW 20          // ms, for keys caught chattering
+
 // Caps Lock as Ctrl/Esc configuration
 #define TAPPING_FORCE_HOLD                  // Makes held keys repeat
 #define HOLD_ON_OTHER_KEY_PRESS             // Immediately trigger hold when another key is pressed
 
+// Boot and wake (fast_wake.h): keys first, RGB later, wake keystroke replayed
+#define FAST_WAKE_RGB_DELAY 20              // ms with the RGB matrix held off after power-on/wake
+#define FAST_WAKE_BUFFER_TIMEOUT 3000       // ms a report waits for Bluetooth to reconnect
+
+// Background work (sched.h), run from housekeeping in scans without key events
+#define SCHED_SCAN_BUDGET_US 250            // µs of background work per scan
+
+// Persisted settings (user_config.h): USER_CONFIG_SLOTS records of 8 bytes
+#define EECONFIG_USER_DATA_SIZE 32
+
 // RGB Configuration (adjust colors to your preference)
 #ifdef RGB_MATRIX_ENABLE
     #define RGB_MATRIX_STARTUP_MODE RGB_MATRIX_SOLID_COLOR
     #define RGB_MATRIX_STARTUP_HUE 0        // White
     #define RGB_MATRIX_STARTUP_SAT 0
     #define RGB_MATRIX_STARTUP_VAL RGB_MATRIX_MAXIMUM_BRIGHTNESS
+
+    // Power management (rgb_power.h): LED current cap, idle dimming, battery mode
+    #define RGB_POWER_CHANNEL_MA 4           // One LED color channel at full PWM (estimate, tune by measuring)
+    #define RGB_POWER_BUDGET_MA 500          // Whole keyboard on USB
+    #define RGB_POWER_BATTERY_BUDGET_MA 150  // Whole keyboard on battery
+    #define RGB_POWER_DIM_TIMEOUT 30000      // Dim after 30 s without a key press
+    #define RGB_POWER_OFF_TIMEOUT 120000     // Base fill off after 2 min (layer indicators stay)
+    #define RGB_POWER_BATTERY_FLUSH_LIMIT 50 // 20 fps on battery instead of 60
+    #define RGB_FADE_TIME 120                // ms for an RCtrl+[/] brightness step to fade in
+    #ifndef __ASSEMBLER__
+        #include <stdint.h>
+        extern uint8_t rgb_power_flush_limit;
+    #endif
+    #define RGB_MATRIX_LED_FLUSH_LIMIT rgb_power_flush_limit
 #endif
 
 #ifdef RGBLIGHT_ENABLE
@@ -0,0 +1,99 @@
+// Asymmetric per-key debounce, see debounce_asym.h.
+
+#include <string.h>
+#include "debounce_asym.h"
+
+_Static_assert(DEBOUNCE_CHATTER_WINDOW <= 255 && DEBOUNCE <= 255, "windows are uint8_t");
+
+typedef struct {
+    uint8_t  timer;  // ms left: pending release while down, hold-off while up
+    uint8_t  chatter;
+    bool     released;     // released_at is valid (not set until the first release)
+    uint16_t released_at;  // timer_read() of the last registered release
+} debounce_key_t;
+
+static debounce_key_t keys[MATRIX_ROWS][MATRIX_COLS];
+static matrix_row_t   timing[MATRIX_ROWS];  // keys with a timer running
+static uint16_t       last_time;
+
+void debounce_init(uint8_t num_rows) {
+    memset(keys, 0, sizeof(keys));
+    memset(timing, 0, sizeof(timing));
+    last_time = timer_read();
+}
+
+void debounce_free(void) {}
+
+uint8_t debounce_chatter_count(uint8_t row, uint8_t col) {
+    return keys[row][col].chatter;
+}
+
+uint8_t debounce_window(uint8_t row, uint8_t col) {
+    return keys[row][col].chatter >= DEBOUNCE_CHATTER_LIMIT ? DEBOUNCE_CHATTER_WINDOW : DEBOUNCE;
+}
+
+static uint8_t tick(uint8_t timer, uint16_t elapsed) {
+    return timer > elapsed ? timer - elapsed : 0;
+}
+
+// One key whose raw state differs from cooked, or whose timer runs. Returns its new cooked state.
+static bool debounce_key(uint8_t row, uint8_t col, bool raw, bool down, uint16_t now, uint16_t elapsed) {
+    debounce_key_t *key = &keys[row][col];
+
+    if (down) {
+        if (raw) {
+            key->timer = 0;  // open for a moment, then closed again: bounce
+        } else if (key->timer == 0) {
+            key->timer = debounce_window(row, col);
+        } else if ((key->timer = tick(key->timer, elapsed)) == 0) {
+            key->released    = true;
+            key->released_at = now;
+            key->timer       = debounce_window(row, col);  // hold-off
+            return false;
+        }
+        return true;
+    }
+
+    key->timer = tick(key->timer, elapsed);
+    if (key->timer == 0 && raw) {
+        if (key->released && TIMER_DIFF_16(now, key->released_at) < DEBOUNCE_CHATTER_MS && key->chatter < 255) {
+            key->chatter++;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    uint16_t now     = timer_read();
+    uint16_t elapsed = TIMER_DIFF_16(now, last_time);
+    last_time        = now;
+
+    bool cooked_changed = false;
+    for (uint8_t row = 0; row < num_rows && row < MATRIX_ROWS; row++) {
+        matrix_row_t todo = (raw[row] ^ cooked[row]) | timing[row];
+        if (!todo) {
+            continue;
+        }
+        matrix_row_t out = cooked[row];
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            matrix_row_t bit = (matrix_row_t)1 << col;
+            if (!(todo & bit)) {
+                continue;
+            }
+            if (debounce_key(row, col, raw[row] & bit, out & bit, now, elapsed)) {
+                out |= bit;
+            } else {
+                out &= ~bit;
+            }
+            if (keys[row][col].timer) {
+                timing[row] |= bit;
+            } else {
+                timing[row] &= ~bit;
+            }
+        }
+        cooked_changed |= out != cooked[row];
+        cooked[row] = out;
+    }
+    return cooked_changed;
+}
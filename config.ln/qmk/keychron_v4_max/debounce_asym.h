@@ -0,0 +1,36 @@
+// Asymmetric per-key debounce (DEBOUNCE_TYPE = custom).
+//
+// A press registers on its first closed sample: a switch that starts closing is
+// being pressed, so there is nothing to wait for. A release registers only once
+// the contact has stayed open for the key's window, which also swallows the
+// bounce at the start of a press. After a release the key ignores new presses
+// for the same window.
+//
+// A press accepted within DEBOUNCE_CHATTER_MS of the key's own release is chatter
+// (no finger re-presses that fast). After DEBOUNCE_CHATTER_LIMIT of those the key
+// is flagged and gets DEBOUNCE_CHATTER_WINDOW instead of DEBOUNCE. Counters
+// start over at boot.
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+#include "debounce.h"
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5  // ms, release window
+#endif
+#ifndef DEBOUNCE_CHATTER_MS
+#    define DEBOUNCE_CHATTER_MS 20
+#endif
+#ifndef DEBOUNCE_CHATTER_LIMIT
+#    define DEBOUNCE_CHATTER_LIMIT 3
+#endif
+#ifndef DEBOUNCE_CHATTER_WINDOW
+#    define DEBOUNCE_CHATTER_WINDOW 20  // ms, for flagged keys
+#endif
+
+// Chatter events seen on a key since boot (saturates at 255).
+uint8_t debounce_chatter_count(uint8_t row, uint8_t col);
+
+// Current release window of a key, DEBOUNCE or DEBOUNCE_CHATTER_WINDOW.
+uint8_t debounce_window(uint8_t row, uint8_t col);
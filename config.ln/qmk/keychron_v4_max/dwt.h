@@ -0,0 +1,25 @@
+// Cortex-M4 DWT cycle counter, shared by the latency tracer and the scheduler.
+//
+// Free-running at the core clock and wraps every 2^32 cycles (about 54 s at
+// 80 MHz): subtract two raw readings first, then scale the difference.
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__ARM_ARCH_7EM__)
+// CMSIS names are not visible from keymap code.
+#    define DEMCR (*(volatile uint32_t *)0xE000EDFC)
+#    define DWT_CTRL (*(volatile uint32_t *)0xE0001000)
+#    define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+
+// Idempotent; each user calls it from its own init.
+static inline void dwt_init(void) {
+    DEMCR |= 1u << 24;  // TRCENA
+    DWT_CTRL |= 1u;     // CYCCNTENA
+}
+
+static inline uint32_t dwt_cycles(void) {
+    return DWT_CYCCNT;
+}
+#endif
@@ -0,0 +1,170 @@
+// Boot and wake sequencing, see fast_wake.h.
+
+#include <string.h>
+#include "fast_wake.h"
+
+typedef enum {
+    HELD_KEYBOARD,
+    HELD_NKRO,
+    HELD_EXTRA,
+} held_kind_t;
+
+typedef struct {
+    uint32_t time;
+    uint8_t  kind;
+    union {
+        report_keyboard_t keyboard;
+        report_nkro_t     nkro;
+        report_extra_t    extra;
+    };
+} held_report_t;
+
+static uint32_t        phase_time[WAKE_PHASE_COUNT];
+static uint8_t         phase_reached;  // bit per wake_phase_t
+static wake_rgb_step_t rgb_step = WAKE_RGB_RUNNING;
+static bool            rgb_held;  // we stopped the RGB task and owe it a restart
+static bool            key_seen;  // key event since the last fast_wake_task()
+static held_report_t   held[FAST_WAKE_BUFFER_SIZE];
+static uint8_t         held_count;
+
+__attribute__((weak)) bool fast_wake_transport_ready(void) {
+    return true;
+}
+
+void fast_wake_mark(wake_phase_t phase) {
+    if (!(phase_reached & (1 << phase))) {
+        phase_reached |= 1 << phase;
+        phase_time[phase] = timer_read32();
+    }
+}
+
+uint32_t fast_wake_phase(wake_phase_t phase) {
+    if (!(phase_reached & (1 << phase))) {
+        return WAKE_NOT_REACHED;
+    }
+    return phase_time[phase] - phase_time[WAKE_START];
+}
+
+void fast_wake_start(void) {
+    phase_reached = 0;
+    fast_wake_mark(WAKE_START);
+    rgb_step = WAKE_RGB_HELD;
+    key_seen = false;
+#ifdef RGB_MATRIX_ENABLE
+    // Not the user's toggle (noeeprom); an RGB task they had turned off stays off
+    if (rgb_matrix_is_enabled()) {
+        rgb_matrix_disable_noeeprom();
+        rgb_held = true;
+    }
+#endif
+}
+
+void fast_wake_key_event(void) {
+    fast_wake_mark(WAKE_FIRST_KEY);
+    key_seen = true;
+}
+
+// One RGB step per scan, and none in a scan that handled a key event.
+wake_rgb_step_t fast_wake_task(void) {
+    if (fast_wake_transport_ready()) {
+        fast_wake_mark(WAKE_TRANSPORT_READY);
+    }
+    bool busy = key_seen;
+    key_seen  = false;
+
+    switch (rgb_step) {
+        case WAKE_RGB_HELD:
+            if (busy || timer_read32() - phase_time[WAKE_START] < FAST_WAKE_RGB_DELAY) {
+                return WAKE_RGB_HELD;
+            }
+            rgb_step = WAKE_RGB_PREPARE;
+            return WAKE_RGB_PREPARE;
+        case WAKE_RGB_PREPARE:
+            if (busy) {
+                return WAKE_RGB_HELD;
+            }
+#ifdef RGB_MATRIX_ENABLE
+            if (rgb_held) {
+                rgb_matrix_enable_noeeprom();
+                rgb_held = false;
+            }
+#endif
+            fast_wake_mark(WAKE_RGB_READY);
+            rgb_step = WAKE_RGB_RUNNING;
+            return WAKE_RGB_RUNNING;
+        default:
+            return WAKE_RGB_RUNNING;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Reports held while the transport is down
+
+static void send(const held_report_t *entry, host_driver_t *out) {
+    switch (entry->kind) {
+        case HELD_KEYBOARD:
+            out->send_keyboard((report_keyboard_t *)&entry->keyboard);
+            break;
+        case HELD_NKRO:
+            out->send_nkro((report_nkro_t *)&entry->nkro);
+            break;
+        default:
+            out->send_extra((report_extra_t *)&entry->extra);
+            break;
+    }
+}
+
+static void expire(void) {
+    uint8_t stale = 0;
+    while (stale < held_count && timer_read32() - held[stale].time > FAST_WAKE_BUFFER_TIMEOUT) {
+        stale++;
+    }
+    if (stale) {
+        held_count -= stale;
+        memmove(held, held + stale, held_count * sizeof(held[0]));
+    }
+}
+
+// When full, the newest report replaces the last one kept: the keystrokes in
+// between are lost, but the host still ends up with the current key state.
+static held_report_t *hold(uint8_t kind) {
+    expire();
+    held_report_t *entry = &held[held_count < FAST_WAKE_BUFFER_SIZE ? held_count++ : FAST_WAKE_BUFFER_SIZE - 1];
+    entry->time          = timer_read32();
+    entry->kind          = kind;
+    return entry;
+}
+
+void fast_wake_hold_keyboard(report_keyboard_t *report) {
+    hold(HELD_KEYBOARD)->keyboard = *report;
+}
+
+void fast_wake_hold_nkro(report_nkro_t *report) {
+    hold(HELD_NKRO)->nkro = *report;
+}
+
+void fast_wake_hold_extra(report_extra_t *report) {
+    hold(HELD_EXTRA)->extra = *report;
+}
+
+bool fast_wake_replay(host_driver_t *out) {
+    if (!fast_wake_transport_ready()) {
+        return false;
+    }
+    fast_wake_mark(WAKE_TRANSPORT_READY);
+    expire();
+    for (uint8_t i = 0; i < held_count; i++) {
+        send(&held[i], out);
+        fast_wake_mark(WAKE_FIRST_REPORT);
+    }
+    held_count = 0;
+    return true;
+}
+
+uint8_t fast_wake_held(void) {
+    return held_count;
+}
+
+void fast_wake_reset(void) {
+    held_count = 0;
+}
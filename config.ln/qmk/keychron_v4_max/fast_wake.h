@@ -0,0 +1,75 @@
+// Boot and wake sequencing: keys first, lights later, nothing lost.
+//
+// - Phases: power-on (keyboard_post_init_user) and wake (suspend_wakeup_init_user)
+//   restart a set of timestamps, so the time from wake to the first key, to the
+//   transport coming up and to the first report the host gets can be measured.
+// - RGB: the keymap's init only does what key handling needs. The RGB matrix is
+//   held off for FAST_WAKE_RGB_DELAY ms, then brought back over separate scans
+//   (frame first, then the RGB task), each in a scan without key events.
+// - Reports: while the transport is not connected (Bluetooth still reconnecting
+//   after sleep) the reports it would drop are kept, and host_shim replays them
+//   in order once it is. The wake keystroke reaches the host instead of being
+//   lost. Reports still go to the transport meanwhile: on wireless, that is what
+//   starts the reconnect.
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifndef FAST_WAKE_RGB_DELAY
+#    define FAST_WAKE_RGB_DELAY 20  // ms after power-on or wake with the RGB matrix held off
+#endif
+#ifndef FAST_WAKE_BUFFER_SIZE
+#    define FAST_WAKE_BUFFER_SIZE 8  // reports kept while the transport is down
+#endif
+#ifndef FAST_WAKE_BUFFER_TIMEOUT
+#    define FAST_WAKE_BUFFER_TIMEOUT 3000  // ms; older reports are stale and dropped, not replayed
+#endif
+
+typedef enum {
+    WAKE_START,            // keyboard_post_init_user or suspend_wakeup_init_user
+    WAKE_INPUT_READY,      // keymap state ready: key events are handled from here
+    WAKE_FIRST_KEY,        // first key event
+    WAKE_TRANSPORT_READY,  // transport connected
+    WAKE_FIRST_REPORT,     // first report handed to a connected transport (live or replayed)
+    WAKE_RGB_READY,        // RGB task running again with the indicator frame built
+    WAKE_PHASE_COUNT,
+} wake_phase_t;
+
+#define WAKE_NOT_REACHED UINT32_MAX
+
+// What the keymap does about RGB this scan (fast_wake_task)
+typedef enum {
+    WAKE_RGB_HELD,     // nothing yet
+    WAKE_RGB_PREPARE,  // build the indicator frame; the RGB task starts on a later scan
+    WAKE_RGB_RUNNING,  // normal RGB housekeeping
+} wake_rgb_step_t;
+
+// Whether the transport delivers reports. Weak; true unless the keymap says otherwise.
+bool fast_wake_transport_ready(void);
+
+// Power-on or wake. Restarts the phases and holds the RGB matrix off if it is on.
+void fast_wake_start(void);
+
+void     fast_wake_mark(wake_phase_t phase);
+// ms from WAKE_START to `phase`, or WAKE_NOT_REACHED
+uint32_t fast_wake_phase(wake_phase_t phase);
+
+// Every key event, from pre_process_record_user.
+void fast_wake_key_event(void);
+
+// From housekeeping, once per scan.
+wake_rgb_step_t fast_wake_task(void);
+
+// From host_shim, before each report goes to the transport: if the transport is
+// up, sends anything kept earlier to `out` first and returns true. Otherwise
+// returns false and the caller keeps the report with fast_wake_hold_*().
+bool fast_wake_replay(host_driver_t *out);
+
+void    fast_wake_hold_keyboard(report_keyboard_t *report);
+void    fast_wake_hold_nkro(report_nkro_t *report);
+void    fast_wake_hold_extra(report_extra_t *report);
+uint8_t fast_wake_held(void);
+
+// Drops held reports. Phases and the RGB sequence restart with fast_wake_start().
+void fast_wake_reset(void);
@@ -0,0 +1,317 @@
+// keymap_bench: benchmark suites for the tapping, layer-switch and RGB paths.
+//
+//   keymap_bench [-n ITERATIONS] [SUITE...]     suites: tapping layer rgb boot
+//
+// "cpu" columns are real host nanoseconds spent inside the hook (mean/max per
+// call); they track relative cost between keymap revisions, not MCU cycles.
+// "latency" is virtual time from the physical press to the first HID report
+// carrying the resulting key, which is what tapping-term changes move.
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+static unsigned iterations = 2000;
+
+static keypos_t key(const char *name) {
+    keypos_t pos;
+    if (!sim_key_lookup(name, &pos)) {
+        fprintf(stderr, "unknown key %s\n", name);
+        exit(2);
+    }
+    return pos;
+}
+
+static void down(const char *name) {
+    sim_key(key(name), true);
+}
+
+static void up(const char *name) {
+    sim_key(key(name), false);
+}
+
+static bool report_has(const sim_report_t *report, uint8_t code, uint8_t mods) {
+    return report->kind == SIM_REPORT_NKRO && (report->nkro.bits[code >> 3] & (1 << (code & 7))) && (report->nkro.mods & mods) == mods;
+}
+
+// Virtual microseconds from `since` to the first report (at or after index
+// `from`) with `code` and `mods` held, or -1 if none was sent.
+static long latency_to(size_t from, uint64_t since, uint8_t code, uint8_t mods) {
+    for (size_t i = from; i < sim_report_count() && i < SIM_LOG_MAX; i++) {
+        const sim_report_t *report = sim_report(i);
+        if (report_has(report, code, mods)) {
+            return (long)(report->time_us - since);
+        }
+    }
+    return -1;
+}
+
+static void print_header(void) {
+    printf("%-8s %-24s %-36s %8s %9s %9s %11s\n", "suite", "case", "hook", "calls", "cpu mean", "cpu max", "latency ms");
+}
+
+static void print_row(const char *suite, const char *name, sim_hook_t hook, double latency_ms) {
+    const sim_timing_t *t = sim_timing(hook);
+    printf("%-8s %-24s %-36s %8u %8lluns %8lluns", suite, name, sim_hook_name(hook), t->calls, (unsigned long long)(t->calls ? t->total_ns / t->calls : 0), (unsigned long long)t->max_ns);
+    if (latency_ms >= 0) {
+        printf(" %11.3f", latency_ms);
+    } else {
+        printf(" %11s", "-");
+    }
+    printf("\n");
+}
+
+// ---------------------------------------------------------------------------
+// tapping: dual-role keys resolved as taps and as holds
+
+typedef struct {
+    const char *name;
+    const char *hold_key;   // key pressed first
+    const char *other_key;  // optional key pressed while hold_key is down
+    uint32_t    hold_ms;    // how long hold_key stays down
+    uint8_t     expect_code;
+    uint8_t     expect_mods;
+    bool        streak;     // "the " typed at 70 ms per key right before (typing_streak.h)
+} tap_case_t;
+
+static const tap_case_t tap_cases[] = {
+    {"letter", "A", NULL, 30, KC_A, 0, false},
+    {"esc tap (CAPS)", "CAPS", NULL, 30, KC_ESC, 0, false},
+    {"enter tap (ENT)", "ENT", NULL, 30, KC_ENT, 0, false},
+    {"grave tap (ESC)", "ESC", NULL, 30, KC_GRV, 0, false},
+    {"ctrl+a (CAPS held)", "CAPS", "A", 60, KC_A, MOD_BIT(KC_LCTL), false},
+    {"rctrl+a (ENT held)", "ENT", "A", 60, KC_A, MOD_BIT(KC_RCTL), false},
+    {"vim left (ESC held+H)", "ESC", "H", 60, KC_LEFT, 0, false},
+    {"esc tap in streak", "CAPS", NULL, 30, KC_ESC, 0, true},
+    {"enter roll in streak", "ENT", "A", 60, KC_ENT, 0, true},
+};
+
+static void type_streak(void) {
+    static const char *const keys[] = {"T", "H", "E", "SPC"};
+    for (size_t i = 0; i < ARRAY_SIZE(keys); i++) {
+        down(keys[i]);
+        sim_run_ms(40);
+        up(keys[i]);
+        sim_run_ms(30);
+    }
+}
+
+static void bench_tapping(void) {
+    for (size_t c = 0; c < ARRAY_SIZE(tap_cases); c++) {
+        const tap_case_t *tc = &tap_cases[c];
+        double            latency_total = 0;
+        unsigned          latency_count = 0;
+
+        sim_reset();
+        sim_timing_reset();
+        for (unsigned i = 0; i < iterations; i++) {
+            if (tc->streak) {
+                type_streak();
+            }
+            size_t from = sim_report_count();
+            down(tc->hold_key);
+            uint64_t pressed_at = sim_now_us();
+            sim_run_ms(tc->other_key ? 10 : tc->hold_ms);
+            if (tc->other_key) {
+                down(tc->other_key);
+                if (!tc->streak) pressed_at = sim_now_us();
+                sim_run_ms(20);
+                up(tc->other_key);
+                sim_run_ms(tc->hold_ms - 30);
+            }
+            up(tc->hold_key);
+            sim_run_ms(TAPPING_TERM + 20);
+
+            long latency = latency_to(from, pressed_at, tc->expect_code, tc->expect_mods);
+            if (latency >= 0) {
+                latency_total += latency / 1000.0;
+                latency_count++;
+            }
+        }
+        // Streak taps never reach process_record_user
+        print_row("tapping", tc->name, tc->streak ? SIM_HOOK_PRE_PROCESS_RECORD : SIM_HOOK_PROCESS_RECORD, latency_count ? latency_total / latency_count : -1);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// layer: Ctrl+Q/W/E/R switching and the momentary VIM layer
+
+static void bench_layer(void) {
+    sim_reset();
+    sim_timing_reset();
+    for (unsigned i = 0; i < iterations; i++) {
+        down("RCTL");
+        sim_run_ms(5);
+        static const char *const keys[] = {"E", "R", "W", "Q"};
+        for (size_t k = 0; k < ARRAY_SIZE(keys); k++) {
+            down(keys[k]);
+            sim_run_ms(5);
+            up(keys[k]);
+            sim_run_ms(5);
+        }
+        up("RCTL");
+        sim_run_ms(5);
+    }
+    print_row("layer", "rctrl+e/r/w/q", SIM_HOOK_PROCESS_RECORD, -1);
+    print_row("layer", "rctrl+e/r/w/q", SIM_HOOK_LAYER_STATE_SET, -1);
+
+    double   latency_total = 0;
+    unsigned latency_count = 0;
+    sim_reset();
+    sim_timing_reset();
+    for (unsigned i = 0; i < iterations; i++) {
+        size_t from = sim_report_count();
+        down("LCTL");
+        sim_run_ms(5);
+        down("J");
+        uint64_t pressed_at = sim_now_us();
+        sim_run_ms(5);
+        up("J");
+        sim_run_ms(5);
+        up("LCTL");
+        sim_run_ms(5);
+
+        long latency = latency_to(from, pressed_at, KC_DOWN, 0);
+        if (latency >= 0) {
+            latency_total += latency / 1000.0;
+            latency_count++;
+        }
+    }
+    print_row("layer", "momentary vim (LCTL+J)", SIM_HOOK_PROCESS_RECORD, latency_count ? latency_total / latency_count : -1);
+    print_row("layer", "momentary vim (LCTL+J)", SIM_HOOK_LAYER_STATE_SET, -1);
+}
+
+// ---------------------------------------------------------------------------
+// rgb: indicator rendering with a steady state and with state changing every
+// frame. The frame itself is rebuilt by a background task in housekeeping.
+
+static void bench_rgb(void) {
+    uint32_t frame_ms = RGB_MATRIX_LED_FLUSH_LIMIT;
+
+    sim_reset();
+    sim_run_ms(frame_ms * 4);
+    sim_timing_reset();
+    sim_run_ms(frame_ms * iterations);
+    print_row("rgb", "steady base", SIM_HOOK_RGB_INDICATORS, -1);
+
+    sim_reset();
+    down("RCTL");
+    down("E");
+    sim_run_ms(frame_ms);
+    up("E");
+    up("RCTL");
+    sim_run_ms(frame_ms * 4);
+    sim_timing_reset();
+    sim_run_ms(frame_ms * iterations);
+    print_row("rgb", "steady vim", SIM_HOOK_RGB_INDICATORS, -1);
+
+    sim_reset();
+    sim_run_ms(frame_ms * 4);
+    sim_timing_reset();
+    for (unsigned i = 0; i < iterations; i++) {
+        down("RCTL");
+        sim_run_ms(frame_ms);
+        up("RCTL");
+        sim_run_ms(frame_ms);
+    }
+    print_row("rgb", "ctrl overlay toggling", SIM_HOOK_RGB_INDICATORS, -1);
+    print_row("rgb", "ctrl overlay toggling", SIM_HOOK_HOUSEKEEPING, -1);
+
+    sim_reset();
+    sim_run_ms(frame_ms * 4);
+    sim_timing_reset();
+    for (unsigned i = 0; i < iterations; i++) {
+        down("LCTL");
+        sim_run_ms(frame_ms);
+        up("LCTL");
+        sim_run_ms(frame_ms);
+    }
+    print_row("rgb", "layer toggling", SIM_HOOK_RGB_INDICATORS, -1);
+    print_row("rgb", "layer toggling", SIM_HOOK_HOUSEKEEPING, -1);
+}
+
+// ---------------------------------------------------------------------------
+// boot: time to the first report for a key pressed at power-on, and for the key
+// that wakes the keyboard while Bluetooth takes WAKE_RECONNECT_MS to reconnect
+
+#define WAKE_RECONNECT_MS 100
+
+static void bench_boot(void) {
+    double latency_total = 0;
+    int    latency_count = 0;
+    sim_timing_reset();
+    for (unsigned i = 0; i < iterations; i++) {
+        sim_reset();
+        down("A");
+        sim_run_ms(10);
+        long latency = latency_to(0, 0, KC_A, 0);
+        if (latency >= 0) {
+            latency_total += latency / 1000.0;
+            latency_count++;
+        }
+        up("A");
+        sim_run_ms(10);
+    }
+    print_row("boot", "key at power-on", SIM_HOOK_POST_INIT, latency_count ? latency_total / latency_count : -1);
+
+    latency_total = 0;
+    latency_count = 0;
+    sim_timing_reset();
+    for (unsigned i = 0; i < iterations; i++) {
+        sim_reset();
+        sim_run_ms(50);
+        sim_set_transport_ready(false);
+        suspend_wakeup_init_user();
+        size_t   from       = sim_report_count();
+        uint64_t pressed_at = sim_now_us();
+        down("A");
+        sim_run_ms(WAKE_RECONNECT_MS);
+        sim_set_transport_ready(true);
+        sim_run_ms(10);
+        long latency = latency_to(from, pressed_at, KC_A, 0);
+        if (latency >= 0) {
+            latency_total += latency / 1000.0;
+            latency_count++;
+        }
+        up("A");
+        sim_run_ms(10);
+    }
+    print_row("boot", "wake key (BT 100 ms)", SIM_HOOK_HOUSEKEEPING, latency_count ? latency_total / latency_count : -1);
+}
+
+// ---------------------------------------------------------------------------
+
+static const struct {
+    const char *name;
+    void (*run)(void);
+} suites[] = {
+    {"tapping", bench_tapping},
+    {"layer", bench_layer},
+    {"rgb", bench_rgb},
+    {"boot", bench_boot},
+};
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt == 'n') {
+            iterations = (unsigned)strtoul(optarg, NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [-n ITERATIONS] [tapping|layer|rgb|boot]...\n", argv[0]);
+            return 2;
+        }
+    }
+
+    print_header();
+    for (size_t s = 0; s < ARRAY_SIZE(suites); s++) {
+        bool selected = optind == argc;
+        for (int i = optind; i < argc; i++) {
+            selected |= strcmp(argv[i], suites[s].name) == 0;
+        }
+        if (selected) {
+            suites[s].run();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+// quantum/debounce.h: the interface a DEBOUNCE_TYPE = custom implementation provides.
+
+#pragma once
+
+#include "qmk_stub.h"
+
+// Reads raw, updates cooked. Returns true if cooked changed.
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed);
+
+void debounce_init(uint8_t num_rows);
+
+void debounce_free(void);
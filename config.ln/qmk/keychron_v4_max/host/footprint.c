@@ -0,0 +1,545 @@
+// Firmware footprint parsing and analysis, see footprint.h.
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "footprint.h"
+
+#define FLASH_START 0x08000000u
+#define FLASH_END 0x10000000u
+
+static void *grow(void *array, size_t *room, size_t count, size_t size) {
+    if (count < *room) {
+        return array;
+    }
+    *room = *room ? *room * 2 : 64;
+    array = realloc(array, *room * size);
+    if (!array) {
+        perror("realloc");
+        exit(2);
+    }
+    return array;
+}
+
+static void copy_name(char *dst, const char *src, size_t len) {
+    if (len >= FP_NAME_MAX) len = FP_NAME_MAX - 1;
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+static bool is_hex(const char *token) {
+    return token[0] == '0' && token[1] == 'x' && isxdigit((unsigned char)token[2]);
+}
+
+// ---------------------------------------------------------------------------
+// Linker map
+
+typedef enum {
+    SECTION_NONE,  // not allocated (debug info), discarded, or the heap
+    SECTION_FLASH,
+    SECTION_RAM,
+    SECTION_BOTH,  // in RAM, initialised from flash
+} section_class_t;
+
+static bool in_flash(unsigned long long address) {
+    return address >= FLASH_START && address < FLASH_END;
+}
+
+static section_class_t output_section(fp_map_t *map, const char *name, const char *address, const char *size, const char *line) {
+    unsigned long long vma   = strtoull(address, NULL, 16);
+    uint32_t           bytes = (uint32_t)strtoul(size, NULL, 16);
+    if (vma == 0) {
+        return SECTION_NONE;
+    }
+    if (strcmp(name, ".heap") == 0) {
+        map->heap += bytes;
+        return SECTION_NONE;
+    }
+    if (in_flash(vma)) {
+        map->flash += bytes;
+        return SECTION_FLASH;
+    }
+    map->ram += bytes;
+    const char *load = strstr(line, "load address ");
+    if (load && in_flash(strtoull(load + strlen("load address "), NULL, 16))) {
+        map->flash += bytes;
+        return SECTION_BOTH;
+    }
+    return SECTION_RAM;
+}
+
+// "path/to/keymap.o" -> "keymap.o", "/lib/libc_nano.a(lib_a-memcpy.o)" -> "libc_nano.a(lib_a-memcpy.o)"
+static void object_name(char *dst, const char *path) {
+    const char *member = strchr(path, '(');
+    const char *base   = path;
+    for (const char *p = path; *p && (!member || p < member); p++) {
+        if (*p == '/') base = p + 1;
+    }
+    copy_name(dst, base, strlen(base));
+}
+
+// Returns the new symbol's index if it still needs a name from the symbol lines
+// that follow (a plain ".text" or "COMMON" section), else -1.
+static long input_section(fp_map_t *map, section_class_t class, const char *section, const char *size, const char *object) {
+    uint32_t bytes = (uint32_t)strtoul(size, NULL, 16);
+    if (class == SECTION_NONE || bytes == 0) {
+        return -1;
+    }
+    map->symbols     = grow(map->symbols, &map->room, map->count, sizeof(fp_symbol_t));
+    fp_symbol_t *sym = &map->symbols[map->count];
+    memset(sym, 0, sizeof(*sym));
+
+    // -ffunction-sections/-fdata-sections: ".text.process_record_user"
+    const char *dot = section[0] == '.' ? strchr(section + 1, '.') : NULL;
+    copy_name(sym->name, dot && dot[1] ? dot + 1 : section, strlen(dot && dot[1] ? dot + 1 : section));
+    object_name(sym->object, object);
+    sym->flash = class == SECTION_RAM ? 0 : bytes;
+    sym->ram   = class == SECTION_FLASH ? 0 : bytes;
+    map->count++;
+    return dot && dot[1] ? -1 : (long)map->count - 1;
+}
+
+bool fp_parse_map(FILE *file, fp_map_t *map) {
+    char            line[1024];
+    char            tok[4][FP_NAME_MAX * 2];
+    bool            in_map = false;
+    section_class_t class  = SECTION_NONE;
+    char            pending_output[FP_NAME_MAX] = "";  // output section name alone on its line
+    char            pending_input[FP_NAME_MAX]  = "";  // same for an input section
+    long            unnamed = -1;
+
+    memset(map, 0, sizeof(*map));
+    while (fgets(line, sizeof(line), file)) {
+        if (!in_map) {
+            in_map = strncmp(line, "Linker script and memory map", 28) == 0;
+            continue;
+        }
+        int n = sscanf(line, "%191s %191s %191s %191s", tok[0], tok[1], tok[2], tok[3]);
+        if (n <= 0) {
+            continue;
+        }
+
+        if (line[0] != ' ') {
+            // Output section, or a top-level statement (LOAD, OUTPUT, /DISCARD/) ending one
+            pending_input[0] = pending_output[0] = '\0';
+            unnamed                              = -1;
+            class                                = SECTION_NONE;
+            if (line[0] == '.' && n >= 3 && is_hex(tok[1]) && is_hex(tok[2])) {
+                class = output_section(map, tok[0], tok[1], tok[2], line);
+            } else if (line[0] == '.' && n == 1) {
+                copy_name(pending_output, tok[0], strlen(tok[0]));
+            }
+            continue;
+        }
+        if (pending_output[0]) {
+            if (n >= 2 && is_hex(tok[0]) && is_hex(tok[1])) {
+                class = output_section(map, pending_output, tok[0], tok[1], line);
+            }
+            pending_output[0] = '\0';
+            continue;
+        }
+
+        if (line[1] != ' ') {
+            // Input section: " .text.foo  0xADDR  0xSIZE  object", or a pattern like " *(.text*)"
+            pending_input[0] = '\0';
+            unnamed          = -1;
+            if (strchr(tok[0], '(') || tok[0][0] == '*') {
+                continue;
+            }
+            if (n >= 4 && is_hex(tok[1]) && is_hex(tok[2])) {
+                unnamed = input_section(map, class, tok[0], tok[2], tok[3]);
+            } else if (n == 1) {
+                copy_name(pending_input, tok[0], strlen(tok[0]));
+            }
+            continue;
+        }
+
+        // Deeper: the rest of a long input section line, or a symbol defined in it
+        if (pending_input[0] && n >= 3 && is_hex(tok[0]) && is_hex(tok[1])) {
+            unnamed          = input_section(map, class, pending_input, tok[1], tok[2]);
+            pending_input[0] = '\0';
+        } else if (unnamed >= 0 && n == 2 && is_hex(tok[0]) && !is_hex(tok[1])) {
+            copy_name(map->symbols[unnamed].name, tok[1], strlen(tok[1]));
+            unnamed = -1;
+        }
+    }
+    return in_map;
+}
+
+void fp_map_free(fp_map_t *map) {
+    free(map->symbols);
+    memset(map, 0, sizeof(*map));
+}
+
+static int by_size(const void *a, const void *b) {
+    const fp_symbol_t *x = a, *y = b;
+    uint64_t           sx = (uint64_t)x->flash + x->ram, sy = (uint64_t)y->flash + y->ram;
+    if (sx != sy) return sx < sy ? 1 : -1;
+    int c = strcmp(x->name, y->name);
+    return c ? c : strcmp(x->object, y->object);
+}
+
+void fp_map_sort(fp_map_t *map) {
+    qsort(map->symbols, map->count, sizeof(fp_symbol_t), by_size);
+}
+
+void fp_map_by_object(const fp_map_t *map, fp_map_t *objects) {
+    memset(objects, 0, sizeof(*objects));
+    objects->flash = map->flash;
+    objects->ram   = map->ram;
+    objects->heap  = map->heap;
+    for (size_t i = 0; i < map->count; i++) {
+        const fp_symbol_t *sym = &map->symbols[i];
+        size_t             j   = 0;
+        while (j < objects->count && strcmp(objects->symbols[j].name, sym->object) != 0) {
+            j++;
+        }
+        if (j == objects->count) {
+            objects->symbols = grow(objects->symbols, &objects->room, objects->count, sizeof(fp_symbol_t));
+            memset(&objects->symbols[j], 0, sizeof(fp_symbol_t));
+            strcpy(objects->symbols[j].name, sym->object);
+            objects->count++;
+        }
+        objects->symbols[j].flash += sym->flash;
+        objects->symbols[j].ram += sym->ram;
+    }
+    fp_map_sort(objects);
+}
+
+// ---------------------------------------------------------------------------
+// Call graph
+
+static uint32_t hash(const char *s) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    while (*s) {
+        h = (h ^ (uint8_t)*s++) * 16777619u;
+    }
+    return h;
+}
+
+// index[] holds function index + 1; 0 is an empty slot
+static size_t *slot(const fp_graph_t *graph, const char *name) {
+    size_t mask = graph->index_size - 1;
+    for (size_t i = hash(name) & mask;; i = (i + 1) & mask) {
+        if (!graph->index[i] || strcmp(graph->funcs[graph->index[i] - 1].name, name) == 0) {
+            return &graph->index[i];
+        }
+    }
+}
+
+static size_t find(const fp_graph_t *graph, const char *name) {
+    if (!graph->index_size) return SIZE_MAX;
+    size_t *s = slot(graph, name);
+    return *s ? *s - 1 : SIZE_MAX;
+}
+
+static void rehash(fp_graph_t *graph) {
+    free(graph->index);
+    graph->index_size = graph->index_size ? graph->index_size * 2 : 1024;
+    graph->index      = calloc(graph->index_size, sizeof(size_t));
+    if (!graph->index) {
+        perror("calloc");
+        exit(2);
+    }
+    for (size_t i = 0; i < graph->count; i++) {
+        *slot(graph, graph->funcs[i].name) = i + 1;
+    }
+}
+
+static size_t intern(fp_graph_t *graph, const char *name, size_t len) {
+    char key[FP_NAME_MAX];
+    copy_name(key, name, len);
+    size_t found = find(graph, key);
+    if (found != SIZE_MAX) {
+        return found;
+    }
+    if ((graph->count + 1) * 2 > graph->index_size) {
+        rehash(graph);
+    }
+    graph->funcs = grow(graph->funcs, &graph->room, graph->count, sizeof(fp_func_t));
+    fp_func_t *f = &graph->funcs[graph->count];
+    memset(f, 0, sizeof(*f));
+    strcpy(f->name, key);
+    f->frame                = -1;
+    *slot(graph, key) = graph->count + 1;
+    return graph->count++;
+}
+
+bool fp_parse_stack_usage(FILE *file, fp_graph_t *graph) {
+    char line[1024];
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '\n' || line[0] == '\0') continue;
+        char *bytes = strchr(line, '\t');
+        if (!bytes) return false;
+        *bytes++ = '\0';
+        char *kind = strchr(bytes, '\t');
+        if (!kind) return false;
+        *kind++ = '\0';
+
+        char   *colon = strrchr(line, ':');
+        char   *name  = colon ? colon + 1 : line;
+        long    frame = strtol(bytes, NULL, 10);
+        size_t  i     = intern(graph, name, strlen(name));
+        if (frame > graph->funcs[i].frame) {
+            graph->funcs[i].frame = (int32_t)frame;
+        }
+        graph->funcs[i].dynamic |= strstr(kind, "dynamic") != NULL;
+    }
+    return true;
+}
+
+static void add_edge(fp_graph_t *graph, size_t from, size_t to) {
+    fp_func_t *f = &graph->funcs[from];
+    for (size_t i = 0; i < f->callee_count; i++) {
+        if (f->callees[i] == to) return;
+    }
+    f->callees                    = grow(f->callees, &f->callee_room, f->callee_count, sizeof(size_t));
+    f->callees[f->callee_count++] = to;
+}
+
+bool fp_parse_disassembly(FILE *file, fp_graph_t *graph) {
+    char   line[1024];
+    size_t current = SIZE_MAX;
+    bool   any     = false;
+
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\n")] = '\0';
+
+        // Function start: "08000200 <Reset_Handler>:"
+        if (isxdigit((unsigned char)line[0])) {
+            char *lt = strchr(line, '<');
+            char *gt = strrchr(line, '>');
+            if (lt && gt && gt > lt && strcmp(gt, ">:") == 0) {
+                current = intern(graph, lt + 1, (size_t)(gt - lt - 1));
+                any     = true;
+            }
+            continue;
+        }
+        if (current == SIZE_MAX) continue;
+
+        // Instruction: " 8000a2c:\tf000 f8f0 \tbl\t8000c10 <foo>"  (x86: "\tcall   401136 <foo>")
+        char *field = strchr(line, '\t');
+        if (!field || !(field = strchr(field + 1, '\t'))) continue;
+        field++;
+        size_t      mlen = strcspn(field, " \t");
+        const char *ops  = field + mlen;
+        bool call = (mlen == 2 && !strncmp(field, "bl", 2)) || (mlen == 3 && !strncmp(field, "blx", 3)) || !strncmp(field, "call", 4);
+        bool jump = (mlen == 1 && field[0] == 'b') || (mlen == 3 && (!strncmp(field, "b.w", 3) || !strncmp(field, "b.n", 3))) || !strncmp(field, "jmp", 3);
+        if (!call && !jump) continue;
+
+        const char *lt = strchr(ops, '<');
+        if (!lt || strchr(ops, '*') || strpbrk(ops, "#;")) {
+            // blx r3, call *%rax, call *0x2fe2(%rip)  # <got entry>
+            if (call) graph->funcs[current].indirect = true;
+            continue;
+        }
+        const char *gt = strchr(lt, '>');
+        if (!gt || memchr(lt, '+', (size_t)(gt - lt))) {
+            continue;  // branch inside a function
+        }
+        size_t target = intern(graph, lt + 1, (size_t)(gt - lt - 1));
+        if (target != current) {
+            add_edge(graph, current, target);
+        }
+    }
+    return any;
+}
+
+void fp_graph_free(fp_graph_t *graph) {
+    for (size_t i = 0; i < graph->count; i++) {
+        free(graph->funcs[i].callees);
+    }
+    free(graph->funcs);
+    free(graph->index);
+    memset(graph, 0, sizeof(*graph));
+}
+
+// ---------------------------------------------------------------------------
+// Stack depth
+
+enum { UNVISITED, VISITING, DONE };
+
+static void visit(fp_graph_t *graph, size_t i) {
+    graph->funcs[i].visit = VISITING;
+
+    fp_func_t *f     = &graph->funcs[i];
+    uint8_t    flags = (f->frame < 0 ? FP_STACK_UNKNOWN : 0) | (f->dynamic ? FP_STACK_DYNAMIC : 0) | (f->indirect ? FP_STACK_INDIRECT : 0);
+    uint32_t   deepest = 0;
+    size_t     worst   = SIZE_MAX;
+    for (size_t c = 0; c < f->callee_count; c++) {
+        size_t callee = f->callees[c];
+        if (graph->funcs[callee].visit == VISITING) {
+            flags |= FP_STACK_RECURSIVE;
+            continue;
+        }
+        if (graph->funcs[callee].visit == UNVISITED) {
+            visit(graph, callee);
+        }
+        flags |= graph->funcs[callee].flags;
+        if (worst == SIZE_MAX || graph->funcs[callee].depth > deepest) {
+            deepest = graph->funcs[callee].depth;
+            worst   = callee;
+        }
+    }
+    f->depth = (f->frame > 0 ? (uint32_t)f->frame : 0) + deepest;
+    f->flags = flags;
+    f->worst = worst;
+    f->visit = DONE;
+}
+
+void fp_stack_depth(fp_graph_t *graph, const char *root, fp_stack_t *result) {
+    memset(result, 0, sizeof(*result));
+    size_t i = find(graph, root);
+    if (i == SIZE_MAX) {
+        result->flags = FP_STACK_NOT_FOUND;
+        snprintf(result->path, sizeof(result->path), "%s", root);
+        return;
+    }
+    // Fresh walk per root, so where a cycle is cut does not depend on earlier roots
+    for (size_t j = 0; j < graph->count; j++) {
+        graph->funcs[j].visit = UNVISITED;
+    }
+    visit(graph, i);
+    result->bytes = graph->funcs[i].depth;
+    result->flags = graph->funcs[i].flags;
+
+    size_t used = 0;
+    for (size_t step = 0; i != SIZE_MAX && step < 64; step++, i = graph->funcs[i].worst) {
+        int n = snprintf(result->path + used, sizeof(result->path) - used, "%s%s", step ? " > " : "", graph->funcs[i].name);
+        if (n < 0 || (size_t)n >= sizeof(result->path) - used) break;
+        used += (size_t)n;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Snapshots
+
+void fp_snapshot_add(fp_snapshot_t *snapshot, const char *kind, const char *name, int64_t value) {
+    snapshot->entries = grow(snapshot->entries, &snapshot->room, snapshot->count, sizeof(fp_entry_t));
+    fp_entry_t *e     = &snapshot->entries[snapshot->count++];
+    snprintf(e->kind, sizeof(e->kind), "%s", kind);
+    snprintf(e->name, sizeof(e->name), "%s", name);
+    e->value = value;
+}
+
+void fp_snapshot_from_map(fp_snapshot_t *snapshot, const fp_map_t *map) {
+    char name[FP_NAME_MAX * 2];
+    fp_snapshot_add(snapshot, "total", "flash", map->flash);
+    fp_snapshot_add(snapshot, "total", "ram", map->ram);
+    for (size_t i = 0; i < map->count; i++) {
+        const fp_symbol_t *sym = &map->symbols[i];
+        snprintf(name, sizeof(name), "%s:%s", sym->object, sym->name);
+        if (sym->flash) fp_snapshot_add(snapshot, "flash", name, sym->flash);
+        if (sym->ram) fp_snapshot_add(snapshot, "ram", name, sym->ram);
+    }
+}
+
+void fp_snapshot_write(FILE *file, const fp_snapshot_t *snapshot) {
+    for (size_t i = 0; i < snapshot->count; i++) {
+        const fp_entry_t *e = &snapshot->entries[i];
+        fprintf(file, "%s\t%s\t%lld\n", e->kind, e->name, (long long)e->value);
+    }
+}
+
+bool fp_snapshot_read(FILE *file, fp_snapshot_t *snapshot) {
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '\n' || line[0] == '#') continue;
+        char *name = strchr(line, '\t');
+        if (!name) return false;
+        *name++     = '\0';
+        char *value = strrchr(name, '\t');
+        if (!value) return false;
+        *value++ = '\0';
+        fp_snapshot_add(snapshot, line, name, strtoll(value, NULL, 10));
+    }
+    return true;
+}
+
+void fp_snapshot_free(fp_snapshot_t *snapshot) {
+    free(snapshot->entries);
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+static int by_key(const void *a, const void *b) {
+    const fp_entry_t *x = a, *y = b;
+    int               c = strcmp(x->kind, y->kind);
+    return c ? c : strcmp(x->name, y->name);
+}
+
+typedef struct {
+    const fp_entry_t *entry;  // for kind and name
+    int64_t           before, after;
+    bool              added, removed;
+} change_t;
+
+static int by_delta(const void *a, const void *b) {
+    const change_t *x = a, *y = b;
+    int64_t         dx = llabs(x->after - x->before), dy = llabs(y->after - y->before);
+    if (dx != dy) return dx < dy ? 1 : -1;
+    return by_key(x->entry, y->entry);
+}
+
+static bool always_shown(const fp_entry_t *e) {
+    return strcmp(e->kind, "total") == 0 || strcmp(e->kind, "stack") == 0;
+}
+
+static void print_change(FILE *out, const change_t *c) {
+    fprintf(out, "  %-6s %+8lld  %-48s %lld -> %lld%s\n", c->entry->kind, (long long)(c->after - c->before), c->entry->name,
+            (long long)c->before, (long long)c->after, c->added ? " (new)" : c->removed ? " (gone)" : "");
+}
+
+void fp_snapshot_diff(FILE *out, const fp_snapshot_t *before, const fp_snapshot_t *after, size_t top) {
+    fp_entry_t *a = malloc((before->count + 1) * sizeof(fp_entry_t));
+    fp_entry_t *b = malloc((after->count + 1) * sizeof(fp_entry_t));
+    change_t   *changes = malloc((before->count + after->count + 1) * sizeof(change_t));
+    if (!a || !b || !changes) {
+        perror("malloc");
+        exit(2);
+    }
+    memcpy(a, before->entries, before->count * sizeof(fp_entry_t));
+    memcpy(b, after->entries, after->count * sizeof(fp_entry_t));
+    qsort(a, before->count, sizeof(fp_entry_t), by_key);
+    qsort(b, after->count, sizeof(fp_entry_t), by_key);
+
+    // Merge the two sorted lists
+    size_t n = 0;
+    for (size_t i = 0, j = 0; i < before->count || j < after->count;) {
+        int c = i == before->count ? 1 : j == after->count ? -1 : by_key(&a[i], &b[j]);
+        if (c < 0) {
+            changes[n++] = (change_t){.entry = &a[i], .before = a[i].value, .removed = true};
+            i++;
+        } else if (c > 0) {
+            changes[n++] = (change_t){.entry = &b[j], .after = b[j].value, .added = true};
+            j++;
+        } else {
+            changes[n++] = (change_t){.entry = &b[j], .before = a[i].value, .after = b[j].value};
+            i++, j++;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(changes[i].entry->kind, "total") == 0) print_change(out, &changes[i]);
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(changes[i].entry->kind, "stack") == 0) print_change(out, &changes[i]);
+    }
+    qsort(changes, n, sizeof(change_t), by_delta);
+    size_t shown = 0, more = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (always_shown(changes[i].entry) || changes[i].after == changes[i].before) continue;
+        if (shown < top) {
+            print_change(out, &changes[i]);
+            shown++;
+        } else {
+            more++;
+        }
+    }
+    if (more) fprintf(out, "  ... %zu more\n", more);
+    if (!shown) fprintf(out, "  no symbol changed\n");
+
+    free(a);
+    free(b);
+    free(changes);
+}
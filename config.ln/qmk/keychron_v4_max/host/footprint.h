@@ -0,0 +1,121 @@
+// Firmware footprint from the build artefacts of `qmk compile`: flash and RAM
+// per symbol from the GNU ld map, and worst-case stack depth below a function
+// from the -fstack-usage files (.su) plus the call graph of `objdump -d`.
+// Used by footprint_main.c and the host tests.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define FP_NAME_MAX 96
+
+// ---------------------------------------------------------------------------
+// Linker map
+
+typedef struct {
+    char     name[FP_NAME_MAX];    // symbol, or the section name when it has none
+    char     object[FP_NAME_MAX];  // object file (basename), "libc.a(memcpy.o)" for archives
+    uint32_t flash;
+    uint32_t ram;  // .data counts for both
+} fp_symbol_t;
+
+typedef struct {
+    fp_symbol_t *symbols;
+    size_t       count, room;
+    uint32_t     flash;  // output sections loaded into flash, padding included
+    uint32_t     ram;    // output sections in RAM, without the heap
+    uint32_t     heap;   // RAM the linker script leaves to the heap (ChibiOS .heap)
+} fp_map_t;
+
+// Parses the "Linker script and memory map" part of a GNU ld map. Output
+// sections at 0x08000000-0x0FFFFFFF are flash; other allocated ones are RAM,
+// and also flash when they have a load address there (.data). Returns false
+// if the file is not a linker map.
+bool fp_parse_map(FILE *file, fp_map_t *map);
+void fp_map_free(fp_map_t *map);
+
+// Symbols sorted by flash + RAM, largest first.
+void fp_map_sort(fp_map_t *map);
+
+// Per object file: `objects` gets one entry per object, named after it, sorted.
+void fp_map_by_object(const fp_map_t *map, fp_map_t *objects);
+
+// ---------------------------------------------------------------------------
+// Stack depth
+
+typedef struct {
+    char    name[FP_NAME_MAX];
+    int32_t frame;     // bytes, from .su; -1 if unknown (assembly, libraries built without it)
+    bool    dynamic;   // .su says the frame depends on runtime values (alloca, VLAs)
+    bool    indirect;  // calls through a pointer, which cannot be followed
+    size_t *callees;
+    size_t  callee_count, callee_room;
+    // fp_stack_depth() state
+    uint8_t  visit;
+    uint8_t  flags;
+    uint32_t depth;
+    size_t   worst;  // callee on the deepest path, or SIZE_MAX
+} fp_func_t;
+
+typedef struct {
+    fp_func_t *funcs;
+    size_t     count, room;
+    size_t    *index;  // hash table of function indexes by name
+    size_t     index_size;
+} fp_graph_t;
+
+// Concatenated .su files: "file:line:col:function<TAB>bytes<TAB>static|dynamic[,bounded]".
+// A name defined in several files (static functions) keeps the largest frame.
+bool fp_parse_stack_usage(FILE *file, fp_graph_t *graph);
+
+// `objdump -d` of the ELF. Direct calls (bl, call) and tail calls to the start of
+// another function (b, b.w, jmp) become edges; blx/call through a register marks
+// the function as making indirect calls.
+bool fp_parse_disassembly(FILE *file, fp_graph_t *graph);
+void fp_graph_free(fp_graph_t *graph);
+
+enum {
+    FP_STACK_UNKNOWN   = 1 << 0,  // a function on some path has no .su entry (counted as 0)
+    FP_STACK_DYNAMIC   = 1 << 1,  // a frame is only an estimate
+    FP_STACK_INDIRECT  = 1 << 2,  // calls through pointers were not followed
+    FP_STACK_RECURSIVE = 1 << 3,  // a cycle was cut; the real depth is unbounded
+    FP_STACK_NOT_FOUND = 1 << 4,  // root is not in the disassembly
+};
+
+typedef struct {
+    uint32_t bytes;
+    uint8_t  flags;
+    char     path[512];  // deepest call chain, "a > b > c"
+} fp_stack_t;
+
+// Worst-case stack used by `root` and everything it calls. Conservative: a tail
+// call counts as a call. The flags say where the number is only a lower bound.
+void fp_stack_depth(fp_graph_t *graph, const char *root, fp_stack_t *result);
+
+// ---------------------------------------------------------------------------
+// Snapshots, for comparing two builds
+
+typedef struct {
+    char    kind[8];              // "total", "flash", "ram", "stack"
+    char    name[FP_NAME_MAX * 2];  // "flash"/"ram" for totals, "object:symbol", or the stack root
+    int64_t value;
+} fp_entry_t;
+
+typedef struct {
+    fp_entry_t *entries;
+    size_t      count, room;
+} fp_snapshot_t;
+
+void fp_snapshot_add(fp_snapshot_t *snapshot, const char *kind, const char *name, int64_t value);
+void fp_snapshot_from_map(fp_snapshot_t *snapshot, const fp_map_t *map);
+
+// One "kind<TAB>name<TAB>value" line per entry.
+void fp_snapshot_write(FILE *file, const fp_snapshot_t *snapshot);
+bool fp_snapshot_read(FILE *file, fp_snapshot_t *snapshot);
+void fp_snapshot_free(fp_snapshot_t *snapshot);
+
+// Totals and stack roots always, then the `top` largest other changes.
+void fp_snapshot_diff(FILE *out, const fp_snapshot_t *before, const fp_snapshot_t *after, size_t top);
@@ -0,0 +1,172 @@
+// footprint: where the firmware's flash and RAM go, and how deep the stack gets
+// below the keymap's hot hooks, from the artefacts of a `qmk compile` build.
+//
+//   footprint -m MAP [-s SU -d DISASM] [-r FUNCTION]... [-p BEFORE] [-o AFTER]
+//             [-n TOP] [-F FLASH] [-R RAM] [-S STACK]
+//
+//   -m   linker map (.build/<target>.map)
+//   -s   the build's .su files concatenated (-fstack-usage, see ../rules.mk)
+//   -d   `arm-none-eabi-objdump -d` of the ELF
+//   -r   function to report the stack depth of; default process_record_user and
+//        rgb_matrix_indicators_advanced_user
+//   -p   snapshot of an earlier build to diff against
+//   -o   write this build's snapshot
+//   -n   objects, symbols and changes listed (default 20)
+//   -F, -R, -S   budgets in bytes: flash, RAM (heap excluded), stack per function
+//
+// Exits 1 when a budget is exceeded, so `make footprint` fails the build.
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "footprint.h"
+
+#define MAX_ROOTS 16
+
+static FILE *open_or_die(const char *path, const char *mode) {
+    FILE *f = fopen(path, mode);
+    if (!f) {
+        perror(path);
+        exit(2);
+    }
+    return f;
+}
+
+static void print_symbols(const char *title, const fp_map_t *map, size_t top, bool objects) {
+    printf("\n%s\n%10s %8s  %s\n", title, "flash", "ram", objects ? "object" : "symbol");
+    for (size_t i = 0; i < map->count && i < top; i++) {
+        const fp_symbol_t *sym = &map->symbols[i];
+        printf("%10u %8u  %s%s%s\n", sym->flash, sym->ram, sym->name, objects ? "" : "  ", objects ? "" : sym->object);
+    }
+    if (map->count > top) printf("%20s  ... %zu more\n", "", map->count - top);
+}
+
+static void print_stack(const fp_stack_t *stack, const char *root) {
+    if (stack->flags & FP_STACK_NOT_FOUND) {
+        printf("  %-40s not in the disassembly\n", root);
+        return;
+    }
+    printf("  %-40s %6u bytes  %s\n", root, stack->bytes, stack->path);
+    if (stack->flags & FP_STACK_RECURSIVE) printf("  %-40s        recursion cut: unbounded\n", "");
+    if (stack->flags & FP_STACK_INDIRECT) printf("  %-40s        lower bound: calls through pointers not followed\n", "");
+    if (stack->flags & FP_STACK_UNKNOWN) printf("  %-40s        lower bound: functions without .su counted as 0\n", "");
+    if (stack->flags & FP_STACK_DYNAMIC) printf("  %-40s        estimate: dynamic frames\n", "");
+}
+
+static bool over(const char *what, long long value, long long budget) {
+    if (budget > 0 && value > budget) {
+        printf("OVER BUDGET: %s %lld > %lld bytes\n", what, value, budget);
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    const char *map_path = NULL, *su_path = NULL, *dis_path = NULL, *before_path = NULL, *after_path = NULL;
+    const char *roots[MAX_ROOTS];
+    size_t      root_count = 0;
+    size_t      top        = 20;
+    long long   flash_budget = 0, ram_budget = 0, stack_budget = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:s:d:r:p:o:n:F:R:S:")) != -1) {
+        switch (opt) {
+            case 'm': map_path = optarg; break;
+            case 's': su_path = optarg; break;
+            case 'd': dis_path = optarg; break;
+            case 'r':
+                if (root_count < MAX_ROOTS) roots[root_count++] = optarg;
+                break;
+            case 'p': before_path = optarg; break;
+            case 'o': after_path = optarg; break;
+            case 'n': top = strtoul(optarg, NULL, 10); break;
+            case 'F': flash_budget = strtoll(optarg, NULL, 10); break;
+            case 'R': ram_budget = strtoll(optarg, NULL, 10); break;
+            case 'S': stack_budget = strtoll(optarg, NULL, 10); break;
+            default: map_path = NULL, optind = argc + 1; break;
+        }
+    }
+    if (!map_path || optind != argc || (!su_path != !dis_path)) {
+        fprintf(stderr, "usage: %s -m MAP [-s SU -d DISASM] [-r FUNCTION]... [-p BEFORE] [-o AFTER] [-n TOP] [-F FLASH] [-R RAM] [-S STACK]\n", argv[0]);
+        return 2;
+    }
+    if (!root_count) {
+        roots[root_count++] = "process_record_user";
+        roots[root_count++] = "rgb_matrix_indicators_advanced_user";
+    }
+
+    fp_map_t map, objects;
+    FILE    *f = open_or_die(map_path, "r");
+    if (!fp_parse_map(f, &map)) {
+        fprintf(stderr, "%s: not a GNU ld map\n", map_path);
+        return 2;
+    }
+    fclose(f);
+    fp_map_sort(&map);
+    fp_map_by_object(&map, &objects);
+
+    printf("flash %u bytes, ram %u bytes (+ %u heap)\n", map.flash, map.ram, map.heap);
+    print_symbols("By object:", &objects, top, true);
+    print_symbols("Largest symbols:", &map, top, false);
+
+    fp_snapshot_t after = {0};
+    fp_snapshot_from_map(&after, &map);
+
+    bool       failed = over("flash", map.flash, flash_budget) | over("ram", map.ram, ram_budget);
+    fp_graph_t graph  = {0};
+    if (su_path) {
+        f = open_or_die(su_path, "r");
+        if (!fp_parse_stack_usage(f, &graph)) {
+            fprintf(stderr, "%s: not -fstack-usage output\n", su_path);
+            return 2;
+        }
+        fclose(f);
+        f = open_or_die(dis_path, "r");
+        if (!fp_parse_disassembly(f, &graph)) {
+            fprintf(stderr, "%s: no functions in the disassembly\n", dis_path);
+            return 2;
+        }
+        fclose(f);
+
+        printf("\nWorst-case stack depth:\n");
+        for (size_t i = 0; i < root_count; i++) {
+            fp_stack_t stack;
+            fp_stack_depth(&graph, roots[i], &stack);
+            print_stack(&stack, roots[i]);
+            if (!(stack.flags & FP_STACK_NOT_FOUND)) {
+                fp_snapshot_add(&after, "stack", roots[i], stack.bytes);
+                char what[FP_NAME_MAX + 8];
+                snprintf(what, sizeof(what), "stack %s", roots[i]);
+                failed |= over(what, stack.bytes, stack_budget);
+            }
+        }
+    }
+
+    if (before_path) {
+        fp_snapshot_t before = {0};
+        f                    = fopen(before_path, "r");
+        if (!f) {
+            printf("\nNo earlier snapshot (%s)\n", before_path);
+        } else if (!fp_snapshot_read(f, &before)) {
+            fprintf(stderr, "%s: not a footprint snapshot\n", before_path);
+            return 2;
+        } else {
+            printf("\nChanges since %s:\n", before_path);
+            fp_snapshot_diff(stdout, &before, &after, top);
+        }
+        if (f) fclose(f);
+        fp_snapshot_free(&before);
+    }
+    if (after_path) {
+        f = open_or_die(after_path, "w");
+        fp_snapshot_write(f, &after);
+        fclose(f);
+    }
+
+    fp_snapshot_free(&after);
+    fp_graph_free(&graph);
+    fp_map_free(&objects);
+    fp_map_free(&map);
+    return failed ? 1 : 0;
+}
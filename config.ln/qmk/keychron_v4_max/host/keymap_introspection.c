@@ -0,0 +1,8 @@
+// Compiles keymap.c the way QMK does (quantum/keymap_introspection.c): by
+// including it, so the size of keymaps[] is visible to the simulator.
+
+#include KEYMAP_C
+
+uint8_t keymap_layer_count(void) {
+    return ARRAY_SIZE(keymaps);
+}
@@ -0,0 +1,237 @@
+// Latency trace decoder, see latency_decode.h.
+
+#include "latency_decode.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+int latency_dump_parse(const uint8_t *data, size_t length, latency_dump_t *dump) {
+    memset(dump, 0, sizeof(*dump));
+    if (length % LATENCY_TRACE_PACKET_SIZE) {
+        return -1;
+    }
+
+    bool   have_info = false;
+    size_t room      = 0;
+    for (size_t off = 0; off < length; off += LATENCY_TRACE_PACKET_SIZE) {
+        const uint8_t *p = data + off;
+        if (p[0] != LATENCY_TRACE_RAW_HID_ID) {
+            return -1;
+        }
+        if (p[1] == LT_CMD_INFO) {
+            if (p[2] != LATENCY_TRACE_VERSION || p[3] != LATENCY_TRACE_ENTRY_SIZE) {
+                return -1;
+            }
+            dump->capacity  = (uint16_t)(p[4] | p[5] << 8);
+            dump->written   = get_u32(p + 6);
+            dump->clock_hz  = get_u32(p + 10);
+            dump->first_seq = dump->written > dump->capacity ? dump->written - dump->capacity : 0;
+            dump->lost      = dump->first_seq;
+            have_info       = true;
+        } else if (p[1] == LT_CMD_READ && have_info) {
+            uint32_t seq   = get_u32(p + 2);
+            uint8_t  count = p[6];
+            if (count > LATENCY_TRACE_ENTRIES_PER_PACKET) {
+                return -1;
+            }
+            uint32_t expected = dump->first_seq + (uint32_t)dump->count;
+            if (seq < expected) {
+                return -1;
+            }
+            if (dump->count == 0) {
+                // Entries overwritten between INFO and the first READ
+                dump->lost += seq - dump->first_seq;
+                dump->first_seq = seq;
+            } else if (seq > expected) {
+                return -1;  // a gap in the middle: the reader fell behind
+            }
+            if (dump->count + count > room) {
+                room                     = room ? room * 2 : 256;
+                latency_entry_t *entries = realloc(dump->entries, room * sizeof(*entries));
+                if (!entries) return -1;
+                dump->entries = entries;
+            }
+            for (uint8_t i = 0; i < count; i++) {
+                const uint8_t   *e     = p + 7 + i * LATENCY_TRACE_ENTRY_SIZE;
+                latency_entry_t *entry = &dump->entries[dump->count++];
+                entry->time            = get_u32(e);
+                entry->stage           = e[4];
+                entry->key             = e[5];
+            }
+        } else if (p[1] != LT_CMD_CLEAR) {
+            return -1;
+        }
+    }
+    return have_info ? 0 : -1;
+}
+
+void latency_dump_free(latency_dump_t *dump) {
+    free(dump->entries);
+    memset(dump, 0, sizeof(*dump));
+}
+
+const char *latency_span_name(latency_span_t span) {
+    static const char *const names[LT_SPAN_COUNT] = {
+        [LT_SPAN_MATRIX_TO_SENT]   = "matrix -> transport",
+        [LT_SPAN_MATRIX_TO_REPORT] = "matrix -> report",
+        [LT_SPAN_TAP_HOLD]         = "matrix -> tap/hold resolved",
+        [LT_SPAN_MATRIX_TO_PRU]    = "matrix -> process_record_user",
+        [LT_SPAN_PRU]              = "process_record_user",
+        [LT_SPAN_PRU_TO_REPORT]    = "process_record_user -> report",
+        [LT_SPAN_REPORT_TO_SENT]   = "report -> transport",
+    };
+    return names[span];
+}
+
+// ---------------------------------------------------------------------------
+// Pairing. Matrix changes queue up per key until process_record_user picks
+// them up (tap/hold keys hold their press and release back); a report is
+// attributed to the key whose process_record_user ran last. Reports generated
+// since the last hand-off all go out with the next one.
+
+#define MATRIX_QUEUE 8
+
+typedef struct {
+    uint32_t matrix[MATRIX_QUEUE];
+    uint8_t  queued;
+    bool     in_record;
+    bool     from_matrix;  // the current record has a matrix timestamp
+    uint32_t record_matrix;
+    uint32_t record_enter;
+    bool     awaiting_report;
+    uint32_t record_exit;
+} key_state_t;
+
+typedef struct {
+    uint32_t generated;
+    bool     from_matrix;
+    uint32_t matrix;
+} unsent_t;
+
+typedef struct {
+    double *samples;
+    size_t  count;
+} samples_t;
+
+static void add_sample(samples_t *s, uint32_t ticks, uint32_t clock_hz) {
+    s->samples[s->count++] = (double)ticks * 1e6 / clock_hz;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t count, double p) {
+    size_t rank = (size_t)ceil(p * count);
+    return sorted[rank ? rank - 1 : 0];
+}
+
+static void summarize(samples_t *s, latency_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->count = s->count;
+    if (s->count == 0) return;
+
+    qsort(s->samples, s->count, sizeof(double), compare_double);
+    stats->p50_us = percentile(s->samples, s->count, 0.50);
+    stats->p99_us = percentile(s->samples, s->count, 0.99);
+    stats->max_us = s->samples[s->count - 1];
+    for (size_t i = 0; i < s->count; i++) {
+        unsigned bucket = 0;
+        while (bucket < LATENCY_HISTOGRAM_BUCKETS - 1 && s->samples[i] >= (double)(1u << bucket)) {
+            bucket++;
+        }
+        stats->histogram[bucket]++;
+    }
+}
+
+void latency_analyze(const latency_dump_t *dump, latency_stats_t stats[LT_SPAN_COUNT]) {
+    static key_state_t keys[256];
+    samples_t          spans[LT_SPAN_COUNT];
+    unsent_t          *unsent  = calloc(dump->count ? dump->count : 1, sizeof(unsent_t));
+    size_t             pending = 0;
+
+    memset(keys, 0, sizeof(keys));
+    for (int s = 0; s < LT_SPAN_COUNT; s++) {
+        spans[s].samples = calloc(dump->count ? dump->count : 1, sizeof(double));
+        spans[s].count   = 0;
+    }
+
+    for (size_t i = 0; i < dump->count; i++) {
+        const latency_entry_t *e = &dump->entries[i];
+        key_state_t           *k = &keys[e->key];
+
+        switch (e->stage) {
+            case LT_MATRIX:
+                if (k->queued == MATRIX_QUEUE) {
+                    memmove(k->matrix, k->matrix + 1, sizeof(k->matrix[0]) * (MATRIX_QUEUE - 1));
+                    k->queued--;
+                }
+                k->matrix[k->queued++] = e->time;
+                break;
+
+            case LT_TAP_RESOLVED:
+                if (k->queued) {
+                    add_sample(&spans[LT_SPAN_TAP_HOLD], e->time - k->matrix[0], dump->clock_hz);
+                }
+                break;
+
+            case LT_PRU_ENTER:
+                k->in_record    = true;
+                k->record_enter = e->time;
+                k->from_matrix  = k->queued > 0;
+                if (k->from_matrix) {
+                    k->record_matrix = k->matrix[0];
+                    memmove(k->matrix, k->matrix + 1, sizeof(k->matrix[0]) * (MATRIX_QUEUE - 1));
+                    k->queued--;
+                    add_sample(&spans[LT_SPAN_MATRIX_TO_PRU], e->time - k->record_matrix, dump->clock_hz);
+                }
+                break;
+
+            case LT_PRU_EXIT:
+                if (!k->in_record) break;
+                k->in_record = false;
+                add_sample(&spans[LT_SPAN_PRU], e->time - k->record_enter, dump->clock_hz);
+                k->awaiting_report = true;
+                k->record_exit     = e->time;
+                break;
+
+            case LT_REPORT: {
+                unsent_t *u    = &unsent[pending++];
+                u->generated   = e->time;
+                u->from_matrix = false;
+                if (!k->awaiting_report) break;
+                k->awaiting_report = false;
+                add_sample(&spans[LT_SPAN_PRU_TO_REPORT], e->time - k->record_exit, dump->clock_hz);
+                if (k->from_matrix) {
+                    u->from_matrix = true;
+                    u->matrix      = k->record_matrix;
+                    add_sample(&spans[LT_SPAN_MATRIX_TO_REPORT], e->time - k->record_matrix, dump->clock_hz);
+                }
+                break;
+            }
+
+            case LT_SENT:
+                for (size_t u = 0; u < pending; u++) {
+                    add_sample(&spans[LT_SPAN_REPORT_TO_SENT], e->time - unsent[u].generated, dump->clock_hz);
+                    if (unsent[u].from_matrix) {
+                        add_sample(&spans[LT_SPAN_MATRIX_TO_SENT], e->time - unsent[u].matrix, dump->clock_hz);
+                    }
+                }
+                pending = 0;
+                break;
+        }
+    }
+    free(unsent);
+
+    for (int s = 0; s < LT_SPAN_COUNT; s++) {
+        summarize(&spans[s], &stats[s]);
+        free(spans[s].samples);
+    }
+}
@@ -0,0 +1,48 @@
+// Decoding of latency trace dumps (see ../latency_trace.h) into per-stage
+// latency statistics. Used by latency_decode_main.c and the host tests.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "latency_trace.h"
+
+typedef struct {
+    uint32_t         clock_hz;
+    uint16_t         capacity;
+    uint32_t         written;    // entries recorded by the keyboard at INFO time
+    uint32_t         first_seq;  // sequence number of entries[0]
+    uint32_t         lost;       // entries overwritten before they were read
+    size_t           count;
+    latency_entry_t *entries;
+} latency_dump_t;
+
+// Parses a capture made of concatenated LATENCY_TRACE_PACKET_SIZE byte raw HID
+// responses (one INFO, then READs in order). Returns 0, or -1 on a malformed capture.
+int  latency_dump_parse(const uint8_t *data, size_t length, latency_dump_t *dump);
+void latency_dump_free(latency_dump_t *dump);
+
+typedef enum {
+    LT_SPAN_MATRIX_TO_SENT,    // end to end: matrix change -> report handed to the transport
+    LT_SPAN_MATRIX_TO_REPORT,  // matrix change -> HID report generated
+    LT_SPAN_TAP_HOLD,          // matrix press -> tap/hold decision
+    LT_SPAN_MATRIX_TO_PRU,     // matrix change -> process_record_user entry
+    LT_SPAN_PRU,               // process_record_user entry -> exit
+    LT_SPAN_PRU_TO_REPORT,     // process_record_user exit -> HID report generated
+    LT_SPAN_REPORT_TO_SENT,    // report generated -> handed to the transport (batching)
+    LT_SPAN_COUNT,
+} latency_span_t;
+
+#define LATENCY_HISTOGRAM_BUCKETS 24  // bucket i counts samples < 2^i us
+
+typedef struct {
+    size_t   count;
+    double   p50_us, p99_us, max_us;
+    uint32_t histogram[LATENCY_HISTOGRAM_BUCKETS];
+} latency_stats_t;
+
+const char *latency_span_name(latency_span_t span);
+
+// Pairs the stages of each keystroke and summarizes every span.
+void latency_analyze(const latency_dump_t *dump, latency_stats_t stats[LT_SPAN_COUNT]);
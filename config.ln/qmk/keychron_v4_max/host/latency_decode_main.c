@@ -0,0 +1,192 @@
+// latency_decode: read the keyboard's latency trace and print per-stage
+// latency histograms.
+//
+//   latency_decode [-H] [-c] [-o CAPTURE] -d /dev/hidrawN    read from the keyboard
+//   latency_decode [-H] CAPTURE                              decode a saved capture
+//
+//   -d   raw HID device of the keyboard (firmware built with LATENCY_TRACE_ENABLE=yes)
+//   -o   also save the raw capture, for later decoding or comparison
+//   -c   clear the trace on the keyboard after reading it
+//   -H   print a log2 histogram per stage, not just p50/p99/max
+//
+// A capture is the keyboard's raw HID responses back to back (latency_trace.h).
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "latency_decode.h"
+
+typedef struct {
+    uint8_t *data;
+    size_t   length, room;
+} buffer_t;
+
+static void append(buffer_t *b, const uint8_t *data, size_t length) {
+    if (b->length + length > b->room) {
+        b->room = (b->length + length) * 2;
+        b->data = realloc(b->data, b->room);
+        if (!b->data) {
+            perror("realloc");
+            exit(2);
+        }
+    }
+    memcpy(b->data + b->length, data, length);
+    b->length += length;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// One request/response round trip. hidraw wants the report ID (0) in front.
+static bool transact(int fd, uint8_t cmd, uint32_t arg, uint8_t response[LATENCY_TRACE_PACKET_SIZE]) {
+    uint8_t request[LATENCY_TRACE_PACKET_SIZE + 1] = {0, LATENCY_TRACE_RAW_HID_ID, cmd, arg & 0xFF, (arg >> 8) & 0xFF, (arg >> 16) & 0xFF, arg >> 24};
+    if (write(fd, request, sizeof(request)) != (ssize_t)sizeof(request)) {
+        perror("write");
+        return false;
+    }
+    // Skip anything else the keyboard sends on the raw HID interface
+    for (int tries = 0; tries < 16; tries++) {
+        ssize_t n = read(fd, response, LATENCY_TRACE_PACKET_SIZE);
+        if (n < 0) {
+            perror("read");
+            return false;
+        }
+        if (n == LATENCY_TRACE_PACKET_SIZE && response[0] == LATENCY_TRACE_RAW_HID_ID && response[1] == cmd) {
+            return true;
+        }
+    }
+    fprintf(stderr, "no latency trace response; is the firmware built with LATENCY_TRACE_ENABLE=yes?\n");
+    return false;
+}
+
+static bool read_device(const char *path, bool clear, buffer_t *capture) {
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+
+    uint8_t packet[LATENCY_TRACE_PACKET_SIZE];
+    bool    ok = transact(fd, LT_CMD_INFO, 0, packet);
+    if (ok) {
+        append(capture, packet, sizeof(packet));
+        uint32_t written  = get_u32(packet + 6);
+        uint16_t capacity = (uint16_t)(packet[4] | packet[5] << 8);
+        uint32_t seq      = written > capacity ? written - capacity : 0;
+        while (ok && seq < written) {
+            ok = transact(fd, LT_CMD_READ, seq, packet);
+            if (ok) {
+                if (packet[6] == 0) break;
+                append(capture, packet, sizeof(packet));
+                seq = get_u32(packet + 2) + packet[6];
+            }
+        }
+    }
+    if (ok && clear) {
+        ok = transact(fd, LT_CMD_CLEAR, 0, packet);
+    }
+    close(fd);
+    return ok;
+}
+
+static bool read_file(const char *path, buffer_t *capture) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    uint8_t chunk[4096];
+    size_t  n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        append(capture, chunk, n);
+    }
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+static void print_stats(const latency_dump_t *dump, const latency_stats_t stats[LT_SPAN_COUNT], bool histogram) {
+    printf("entries %zu (%u lost), clock %u Hz\n\n", dump->count, dump->lost, dump->clock_hz);
+    printf("%-32s %7s %10s %10s %10s\n", "stage", "count", "p50 us", "p99 us", "max us");
+    for (latency_span_t span = 0; span < LT_SPAN_COUNT; span++) {
+        const latency_stats_t *s = &stats[span];
+        printf("%-32s %7zu %10.1f %10.1f %10.1f\n", latency_span_name(span), s->count, s->p50_us, s->p99_us, s->max_us);
+    }
+    if (!histogram) return;
+
+    for (latency_span_t span = 0; span < LT_SPAN_COUNT; span++) {
+        const latency_stats_t *s = &stats[span];
+        if (s->count == 0) continue;
+        printf("\n%s\n", latency_span_name(span));
+        uint32_t peak = 0;
+        for (int b = 0; b < LATENCY_HISTOGRAM_BUCKETS; b++) {
+            if (s->histogram[b] > peak) peak = s->histogram[b];
+        }
+        for (int b = 0; b < LATENCY_HISTOGRAM_BUCKETS; b++) {
+            if (s->histogram[b] == 0) continue;
+            int width = (int)((s->histogram[b] * 40 + peak - 1) / peak);
+            printf("  < %8u us %7u %.*s\n", 1u << b, s->histogram[b], width, "########################################");
+        }
+    }
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-H] [-c] [-o CAPTURE] -d /dev/hidrawN\n       %s [-H] CAPTURE\n", argv0, argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    const char *device = NULL, *output = NULL;
+    bool        histogram = false, clear = false;
+    int         opt;
+    while ((opt = getopt(argc, argv, "d:o:cH")) != -1) {
+        switch (opt) {
+            case 'd':
+                device = optarg;
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            case 'c':
+                clear = true;
+                break;
+            case 'H':
+                histogram = true;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (device ? optind != argc : optind != argc - 1) {
+        usage(argv[0]);
+    }
+
+    buffer_t capture = {0};
+    if (!(device ? read_device(device, clear, &capture) : read_file(argv[optind], &capture))) {
+        return 1;
+    }
+    if (output) {
+        FILE *f = fopen(output, "wb");
+        if (!f || fwrite(capture.data, 1, capture.length, f) != capture.length || fclose(f) != 0) {
+            perror(output);
+            return 1;
+        }
+    }
+
+    latency_dump_t dump;
+    if (latency_dump_parse(capture.data, capture.length, &dump) != 0) {
+        fprintf(stderr, "malformed capture\n");
+        return 1;
+    }
+    latency_stats_t stats[LT_SPAN_COUNT];
+    latency_analyze(&dump, stats);
+    print_stats(&dump, stats, histogram);
+    latency_dump_free(&dump);
+    free(capture.data);
+    return 0;
+}
@@ -0,0 +1,336 @@
+// Host implementation of the QMK API declared in qmk_stub.h.
+//
+// Layer, modifier and report handling mirror quantum/action_layer.c and
+// quantum/action_util.c closely enough that the keymap sees the same state
+// transitions and the host driver sees the same reports as on the keyboard.
+
+#include "qmk_stub.h"
+#include "sim.h"
+
+// ---------------------------------------------------------------------------
+// Weak user hooks
+
+__attribute__((weak)) void keyboard_post_init_user(void) {}
+
+__attribute__((weak)) void suspend_power_down_user(void) {}
+
+__attribute__((weak)) void suspend_wakeup_init_user(void) {}
+
+__attribute__((weak)) bool pre_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    return true;
+}
+
+__attribute__((weak)) bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    return true;
+}
+
+__attribute__((weak)) uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record) {
+    return TAPPING_TERM;
+}
+
+__attribute__((weak)) layer_state_t layer_state_set_user(layer_state_t state) {
+    return state;
+}
+
+__attribute__((weak)) void housekeeping_task_user(void) {}
+
+__attribute__((weak)) void matrix_scan_user(void) {}
+
+__attribute__((weak)) void raw_hid_receive(uint8_t *data, uint8_t length) {}
+
+__attribute__((weak)) bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Layers
+
+layer_state_t layer_state         = 0;
+layer_state_t default_layer_state = 0;
+
+void default_layer_set(layer_state_t state) {
+    default_layer_state = state;
+}
+
+void layer_state_set(layer_state_t state) {
+    SIM_TIMED(SIM_HOOK_LAYER_STATE_SET, state = layer_state_set_user(state));
+    layer_state = state;
+}
+
+void layer_clear(void) {
+    layer_state_set(0);
+}
+
+void layer_move(uint8_t layer) {
+    layer_state_set((layer_state_t)1 << layer);
+}
+
+void layer_on(uint8_t layer) {
+    layer_state_set(layer_state | ((layer_state_t)1 << layer));
+}
+
+void layer_off(uint8_t layer) {
+    layer_state_set(layer_state & ~((layer_state_t)1 << layer));
+}
+
+bool layer_state_is(uint8_t layer) {
+    return (layer_state >> layer) & 1;
+}
+
+uint8_t get_highest_layer(layer_state_t state) {
+    uint8_t layer = 0;
+    while (state >>= 1) {
+        layer++;
+    }
+    return layer;
+}
+
+// ---------------------------------------------------------------------------
+// Modifiers and keys
+
+static uint8_t       real_mods;
+static uint8_t       weak_mods;
+static report_nkro_t nkro_report;
+static report_nkro_t last_nkro_report;
+
+uint8_t get_mods(void) {
+    return real_mods;
+}
+
+void add_mods(uint8_t mods) {
+    real_mods |= mods;
+}
+
+void del_mods(uint8_t mods) {
+    real_mods &= ~mods;
+}
+
+void set_mods(uint8_t mods) {
+    real_mods = mods;
+}
+
+void clear_mods(void) {
+    real_mods = 0;
+}
+
+uint8_t get_weak_mods(void) {
+    return weak_mods;
+}
+
+void add_weak_mods(uint8_t mods) {
+    weak_mods |= mods;
+}
+
+void del_weak_mods(uint8_t mods) {
+    weak_mods &= ~mods;
+}
+
+void clear_weak_mods(void) {
+    weak_mods = 0;
+}
+
+// Like QMK, an unchanged report is never sent twice in a row.
+void send_keyboard_report(void) {
+    nkro_report.mods = real_mods | weak_mods;
+    if (memcmp(&nkro_report, &last_nkro_report, sizeof(nkro_report)) != 0) {
+        last_nkro_report = nkro_report;
+        host_nkro_send(&nkro_report);
+    }
+}
+
+static uint16_t consumer_usage(uint8_t code) {
+    switch (code) {
+        case KC_AUDIO_MUTE:
+            return 0x00E2;
+        case KC_AUDIO_VOL_UP:
+            return 0x00E9;
+        case KC_AUDIO_VOL_DOWN:
+            return 0x00EA;
+    }
+    return 0;
+}
+
+// Report edits without sending (action_util.h add_key/del_key)
+void add_key(uint8_t code) {
+    nkro_report.bits[code >> 3] |= 1 << (code & 7);
+}
+
+void del_key(uint8_t code) {
+    nkro_report.bits[code >> 3] &= ~(1 << (code & 7));
+}
+
+void register_code(uint8_t code) {
+    if (code == KC_NO) {
+        return;
+    }
+    if (IS_MODIFIER_KEYCODE(code)) {
+        add_mods(MOD_BIT(code));
+    } else if (IS_CONSUMER_KEYCODE(code)) {
+        host_consumer_send(consumer_usage(code));
+        return;
+    } else {
+        add_key(code);
+    }
+    send_keyboard_report();
+}
+
+void unregister_code(uint8_t code) {
+    if (code == KC_NO) {
+        return;
+    }
+    if (IS_MODIFIER_KEYCODE(code)) {
+        del_mods(MOD_BIT(code));
+    } else if (IS_CONSUMER_KEYCODE(code)) {
+        host_consumer_send(0);
+        return;
+    } else {
+        del_key(code);
+    }
+    send_keyboard_report();
+}
+
+void tap_code(uint8_t code) {
+    register_code(code);
+    unregister_code(code);
+}
+
+void clear_keyboard(void) {
+    clear_mods();
+    clear_weak_mods();
+    memset(nkro_report.bits, 0, sizeof(nkro_report.bits));
+    send_keyboard_report();
+}
+
+// ---------------------------------------------------------------------------
+// Host driver
+
+static host_driver_t *driver;
+static uint16_t       last_consumer_usage;
+
+void host_set_driver(host_driver_t *d) {
+    driver = d;
+}
+
+host_driver_t *host_get_driver(void) {
+    return driver;
+}
+
+void host_keyboard_send(report_keyboard_t *report) {
+    if (driver && driver->send_keyboard) driver->send_keyboard(report);
+}
+
+void host_nkro_send(report_nkro_t *report) {
+    if (driver && driver->send_nkro) driver->send_nkro(report);
+}
+
+void host_consumer_send(uint16_t usage) {
+    if (usage == last_consumer_usage) {
+        return;
+    }
+    last_consumer_usage = usage;
+
+    report_extra_t report = {.report_id = REPORT_ID_CONSUMER, .usage = usage};
+    if (driver && driver->send_extra) driver->send_extra(&report);
+}
+
+// ---------------------------------------------------------------------------
+// EEPROM
+
+static uint8_t  eeprom[SIM_EEPROM_SIZE];
+static uint32_t eeprom_writes;
+
+void eeprom_read_block(void *buf, const void *addr, size_t len) {
+    memcpy(buf, &eeprom[(uintptr_t)addr], len);
+}
+
+// Like the wear-leveling driver, unchanged bytes are not written
+void eeprom_update_block(const void *buf, void *addr, size_t len) {
+    if (memcmp(&eeprom[(uintptr_t)addr], buf, len) != 0) {
+        memcpy(&eeprom[(uintptr_t)addr], buf, len);
+        eeprom_writes++;
+    }
+}
+
+uint8_t eeconfig_read_default_layer(void) {
+    return eeprom[(uintptr_t)EECONFIG_DEFAULT_LAYER];
+}
+
+void eeconfig_update_default_layer(uint8_t val) {
+    eeprom_update_block(&val, EECONFIG_DEFAULT_LAYER, 1);
+}
+
+uint8_t *sim_eeprom(void) {
+    return eeprom;
+}
+
+uint32_t sim_eeprom_writes(void) {
+    return eeprom_writes;
+}
+
+void sim_eeprom_erase(void) {
+    memset(eeprom, 0, sizeof(eeprom));
+    eeprom_writes = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Timer
+
+uint16_t timer_read(void) {
+    return (uint16_t)(sim_now_us() / 1000);
+}
+
+uint32_t timer_read32(void) {
+    return (uint32_t)(sim_now_us() / 1000);
+}
+
+uint16_t timer_elapsed(uint16_t last) {
+    return TIMER_DIFF_16(timer_read(), last);
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return TIMER_DIFF_32(timer_read32(), last);
+}
+
+// ---------------------------------------------------------------------------
+// RGB matrix
+
+static bool rgb_enabled = true;
+
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
+    if (index >= 0 && index < RGB_MATRIX_LED_COUNT) {
+        sim_led_buffer[index] = (rgb_t){red, green, blue};
+    }
+}
+
+void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
+    for (int i = 0; i < RGB_MATRIX_LED_COUNT; i++) {
+        rgb_matrix_set_color(i, red, green, blue);
+    }
+}
+
+bool rgb_matrix_is_enabled(void) {
+    return rgb_enabled;
+}
+
+void rgb_matrix_enable_noeeprom(void) {
+    rgb_enabled = true;
+}
+
+void rgb_matrix_disable_noeeprom(void) {
+    rgb_enabled = false;
+}
+
+// ---------------------------------------------------------------------------
+
+void qmk_stub_reset(void) {
+    layer_state         = 0;
+    default_layer_state = 1;
+    real_mods           = 0;
+    weak_mods           = 0;
+    memset(&nkro_report, 0, sizeof(nkro_report));
+    nkro_report.report_id = REPORT_ID_NKRO;
+    last_nkro_report      = nkro_report;
+    rgb_enabled           = true;
+    driver                = NULL;
+    last_consumer_usage   = 0;
+}
@@ -0,0 +1,384 @@
+// Minimal stand-in for the QMK API used by keymap.c, so the keymap can be
+// compiled and exercised on Linux. Included as QMK_KEYBOARD_H by host/Makefile.
+//
+// Keycode values, modifier bits and report layouts follow upstream QMK so that
+// traces read the same as on the keyboard. Only what the keymap touches is here.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// Board (keychron/v4_max/ansi)
+
+#define MATRIX_ROWS 5
+#define MATRIX_COLS 14
+#define RGB_MATRIX_LED_COUNT 61
+#define RGB_MATRIX_LED_PROCESS_LIMIT ((RGB_MATRIX_LED_COUNT + 4) / 5)
+#ifndef RGB_MATRIX_LED_FLUSH_LIMIT
+#    define RGB_MATRIX_LED_FLUSH_LIMIT 16
+#endif
+#define RGB_MATRIX_MAXIMUM_BRIGHTNESS 255
+#define NO_LED 255
+
+// ---------------------------------------------------------------------------
+// progmem.h / util.h
+
+#define PROGMEM
+#define pgm_read_byte(address) (*((const uint8_t *)(address)))
+#define pgm_read_word(address) (*((const uint16_t *)(address)))
+#define pgm_read_ptr(address) (*((void *const *)(address)))
+#define ARRAY_SIZE(array) (sizeof((array)) / sizeof((array)[0]))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+// ---------------------------------------------------------------------------
+// Keycodes (keycodes.h)
+
+enum qk_keycode_defines {
+    KC_NO = 0x0000,
+    KC_TRANSPARENT = 0x0001,
+    KC_A = 0x0004, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H, KC_I, KC_J, KC_K, KC_L, KC_M,
+    KC_N, KC_O, KC_P, KC_Q, KC_R, KC_S, KC_T, KC_U, KC_V, KC_W, KC_X, KC_Y, KC_Z,
+    KC_1 = 0x001E, KC_2, KC_3, KC_4, KC_5, KC_6, KC_7, KC_8, KC_9, KC_0,
+    KC_ENTER = 0x0028,
+    KC_ESCAPE = 0x0029,
+    KC_BACKSPACE = 0x002A,
+    KC_TAB = 0x002B,
+    KC_SPACE = 0x002C,
+    KC_MINUS = 0x002D,
+    KC_EQUAL = 0x002E,
+    KC_LEFT_BRACKET = 0x002F,
+    KC_RIGHT_BRACKET = 0x0030,
+    KC_BACKSLASH = 0x0031,
+    KC_SEMICOLON = 0x0033,
+    KC_QUOTE = 0x0034,
+    KC_GRAVE = 0x0035,
+    KC_COMMA = 0x0036,
+    KC_DOT = 0x0037,
+    KC_SLASH = 0x0038,
+    KC_CAPS_LOCK = 0x0039,
+    KC_HOME = 0x004A,
+    KC_PAGE_UP = 0x004B,
+    KC_DELETE = 0x004C,
+    KC_END = 0x004D,
+    KC_PAGE_DOWN = 0x004E,
+    KC_RIGHT = 0x004F,
+    KC_LEFT = 0x0050,
+    KC_DOWN = 0x0051,
+    KC_UP = 0x0052,
+    KC_AUDIO_MUTE = 0x00A8,
+    KC_AUDIO_VOL_UP = 0x00A9,
+    KC_AUDIO_VOL_DOWN = 0x00AA,
+    KC_LEFT_CTRL = 0x00E0,
+    KC_LEFT_SHIFT = 0x00E1,
+    KC_LEFT_ALT = 0x00E2,
+    KC_LEFT_GUI = 0x00E3,
+    KC_RIGHT_CTRL = 0x00E4,
+    KC_RIGHT_SHIFT = 0x00E5,
+    KC_RIGHT_ALT = 0x00E6,
+    KC_RIGHT_GUI = 0x00E7,
+};
+
+#define KC_TRNS KC_TRANSPARENT
+#define _______ KC_TRANSPARENT
+#define XXXXXXX KC_NO
+#define KC_ENT KC_ENTER
+#define KC_ESC KC_ESCAPE
+#define KC_BSPC KC_BACKSPACE
+#define KC_SPC KC_SPACE
+#define KC_MINS KC_MINUS
+#define KC_EQL KC_EQUAL
+#define KC_LBRC KC_LEFT_BRACKET
+#define KC_RBRC KC_RIGHT_BRACKET
+#define KC_BSLS KC_BACKSLASH
+#define KC_SCLN KC_SEMICOLON
+#define KC_QUOT KC_QUOTE
+#define KC_GRV KC_GRAVE
+#define KC_COMM KC_COMMA
+#define KC_SLSH KC_SLASH
+#define KC_CAPS KC_CAPS_LOCK
+#define KC_PGUP KC_PAGE_UP
+#define KC_DEL KC_DELETE
+#define KC_PGDN KC_PAGE_DOWN
+#define KC_RGHT KC_RIGHT
+#define KC_MUTE KC_AUDIO_MUTE
+#define KC_VOLU KC_AUDIO_VOL_UP
+#define KC_VOLD KC_AUDIO_VOL_DOWN
+#define KC_LCTL KC_LEFT_CTRL
+#define KC_LSFT KC_LEFT_SHIFT
+#define KC_LALT KC_LEFT_ALT
+#define KC_LGUI KC_LEFT_GUI
+#define KC_RCTL KC_RIGHT_CTRL
+#define KC_RSFT KC_RIGHT_SHIFT
+#define KC_RALT KC_RIGHT_ALT
+#define KC_RGUI KC_RIGHT_GUI
+
+#define IS_BASIC_KEYCODE(code) ((code) >= KC_A && (code) <= 0x00DF)
+#define IS_MODIFIER_KEYCODE(code) ((code) >= KC_LEFT_CTRL && (code) <= KC_RIGHT_GUI)
+#define IS_CONSUMER_KEYCODE(code) ((code) >= KC_AUDIO_MUTE && (code) <= KC_AUDIO_VOL_DOWN)
+
+// Quantum keycode ranges
+#define QK_BASIC 0x0000
+#define QK_BASIC_MAX 0x00FF
+#define QK_MODS 0x0100
+#define QK_MODS_MAX 0x1FFF
+#define QK_MOD_TAP 0x2000
+#define QK_MOD_TAP_MAX 0x3FFF
+#define QK_LAYER_TAP 0x4000
+#define QK_LAYER_TAP_MAX 0x4FFF
+#define QK_TO 0x5200
+#define QK_TO_MAX 0x521F
+#define QK_MOMENTARY 0x5220
+#define QK_MOMENTARY_MAX 0x523F
+
+#define IS_QK_MODS(code) ((code) >= QK_MODS && (code) <= QK_MODS_MAX)
+#define IS_QK_MOD_TAP(code) ((code) >= QK_MOD_TAP && (code) <= QK_MOD_TAP_MAX)
+#define IS_QK_LAYER_TAP(code) ((code) >= QK_LAYER_TAP && (code) <= QK_LAYER_TAP_MAX)
+#define IS_QK_TO(code) ((code) >= QK_TO && (code) <= QK_TO_MAX)
+#define IS_QK_MOMENTARY(code) ((code) >= QK_MOMENTARY && (code) <= QK_MOMENTARY_MAX)
+
+// 5-bit modifier encoding used inside keycodes (bit 4 selects the right-hand side)
+#define MOD_LCTL 0x01
+#define MOD_LSFT 0x02
+#define MOD_LALT 0x04
+#define MOD_LGUI 0x08
+#define MOD_RCTL 0x11
+#define MOD_RSFT 0x12
+#define MOD_RALT 0x14
+#define MOD_RGUI 0x18
+
+#define LT(layer, kc) (QK_LAYER_TAP | (((layer) & 0xF) << 8) | ((kc) & 0xFF))
+#define MT(mod, kc) (QK_MOD_TAP | (((mod) & 0x1F) << 8) | ((kc) & 0xFF))
+#define TO(layer) (QK_TO | ((layer) & 0x1F))
+#define MO(layer) (QK_MOMENTARY | ((layer) & 0x1F))
+#define LSFT(kc) (QK_MODS | (MOD_LSFT << 8) | ((kc) & 0xFF))
+
+#define QK_MOD_TAP_GET_MODS(kc) (((kc) >> 8) & 0x1F)
+#define QK_MOD_TAP_GET_TAP_KEYCODE(kc) ((kc) & 0xFF)
+#define QK_LAYER_TAP_GET_LAYER(kc) (((kc) >> 8) & 0xF)
+#define QK_LAYER_TAP_GET_TAP_KEYCODE(kc) ((kc) & 0xFF)
+#define QK_MODS_GET_MODS(kc) (((kc) >> 8) & 0x1F)
+#define QK_MODS_GET_BASIC_KEYCODE(kc) ((kc) & 0xFF)
+
+// 8-bit modifier bits as they appear in HID reports and get_mods()
+#define MOD_BIT(code) (1 << ((code) & 0x07))
+#define MOD_MASK_CTRL (MOD_BIT(KC_LEFT_CTRL) | MOD_BIT(KC_RIGHT_CTRL))
+#define MOD_MASK_SHIFT (MOD_BIT(KC_LEFT_SHIFT) | MOD_BIT(KC_RIGHT_SHIFT))
+#define MOD_MASK_ALT (MOD_BIT(KC_LEFT_ALT) | MOD_BIT(KC_RIGHT_ALT))
+#define MOD_MASK_GUI (MOD_BIT(KC_LEFT_GUI) | MOD_BIT(KC_RIGHT_GUI))
+
+// ---------------------------------------------------------------------------
+// Layout
+
+// clang-format off
+#define LAYOUT_ansi_61( \
+    K00, K01, K02, K03, K04, K05, K06, K07, K08, K09, K0A, K0B, K0C, K0D, \
+    K10, K11, K12, K13, K14, K15, K16, K17, K18, K19, K1A, K1B, K1C, K1D, \
+    K20, K21, K22, K23, K24, K25, K26, K27, K28, K29, K2A, K2B,      K2D, \
+    K30,      K32, K33, K34, K35, K36, K37, K38, K39, K3A, K3B,      K3D, \
+    K40, K41, K42,                K46,                K4A, K4B, K4C, K4D  \
+) { \
+    { K00, K01, K02,   K03,   K04,   K05,   K06, K07,   K08,   K09,   K0A, K0B, K0C,   K0D }, \
+    { K10, K11, K12,   K13,   K14,   K15,   K16, K17,   K18,   K19,   K1A, K1B, K1C,   K1D }, \
+    { K20, K21, K22,   K23,   K24,   K25,   K26, K27,   K28,   K29,   K2A, K2B, KC_NO, K2D }, \
+    { K30, KC_NO, K32, K33,   K34,   K35,   K36, K37,   K38,   K39,   K3A, K3B, KC_NO, K3D }, \
+    { K40, K41, K42,   KC_NO, KC_NO, KC_NO, K46, KC_NO, KC_NO, KC_NO, K4A, K4B, K4C,   K4D }  \
+}
+// clang-format on
+
+extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
+
+// ---------------------------------------------------------------------------
+// Matrix (matrix.h) — the debounced state, owned by the simulator
+
+typedef uint16_t matrix_row_t;
+
+matrix_row_t matrix_get_row(uint8_t row);
+
+// ---------------------------------------------------------------------------
+// Events and records (keyboard.h / action.h)
+
+typedef struct {
+    uint8_t col;
+    uint8_t row;
+} keypos_t;
+
+typedef enum {
+    TICK_EVENT = 0,
+    KEY_EVENT  = 1,
+} keyevent_type_t;
+
+typedef struct {
+    keypos_t        key;
+    uint16_t        time;
+    keyevent_type_t type;
+    bool            pressed;
+} keyevent_t;
+
+typedef struct {
+    bool    interrupted : 1;
+    bool    reserved2 : 1;
+    bool    reserved1 : 1;
+    bool    reserved0 : 1;
+    uint8_t count : 4;
+} tap_t;
+
+typedef struct {
+    keyevent_t event;
+    tap_t      tap;
+    uint16_t   keycode;
+} keyrecord_t;
+
+// ---------------------------------------------------------------------------
+// Layers (action_layer.h)
+
+typedef uint32_t layer_state_t;
+
+extern layer_state_t layer_state;
+extern layer_state_t default_layer_state;
+
+void    default_layer_set(layer_state_t state);
+void    layer_state_set(layer_state_t state);
+void    layer_clear(void);
+void    layer_move(uint8_t layer);
+void    layer_on(uint8_t layer);
+void    layer_off(uint8_t layer);
+bool    layer_state_is(uint8_t layer);
+uint8_t get_highest_layer(layer_state_t state);
+
+// ---------------------------------------------------------------------------
+// Modifiers and keys (action_util.h / action.h)
+
+uint8_t get_mods(void);
+void    add_mods(uint8_t mods);
+void    del_mods(uint8_t mods);
+void    set_mods(uint8_t mods);
+void    clear_mods(void);
+uint8_t get_weak_mods(void);
+void    add_weak_mods(uint8_t mods);
+void    del_weak_mods(uint8_t mods);
+void    clear_weak_mods(void);
+
+void add_key(uint8_t code);
+void del_key(uint8_t code);
+void register_code(uint8_t code);
+void unregister_code(uint8_t code);
+void tap_code(uint8_t code);
+void send_keyboard_report(void);
+void clear_keyboard(void);
+
+// ---------------------------------------------------------------------------
+// Host driver and reports (host.h / report.h)
+
+#define NKRO_REPORT_BITS 30
+#define KEYBOARD_REPORT_KEYS 6
+
+enum hid_report_ids {
+    REPORT_ID_ALL = 0,
+    REPORT_ID_KEYBOARD,
+    REPORT_ID_MOUSE,
+    REPORT_ID_SYSTEM,
+    REPORT_ID_CONSUMER,
+    REPORT_ID_PROGRAMMABLE_BUTTON,
+    REPORT_ID_NKRO,
+};
+
+typedef struct {
+    uint8_t mods;
+    uint8_t reserved;
+    uint8_t keys[KEYBOARD_REPORT_KEYS];
+} report_keyboard_t;
+
+typedef struct {
+    uint8_t report_id;
+    uint8_t mods;
+    uint8_t bits[NKRO_REPORT_BITS];
+} report_nkro_t;
+
+typedef struct {
+    uint8_t  report_id;
+    uint16_t usage;
+} report_extra_t;
+
+typedef struct {
+    uint8_t buttons;
+    int8_t  x, y, v, h;
+} report_mouse_t;
+
+typedef struct {
+    uint8_t (*keyboard_leds)(void);
+    void (*send_keyboard)(report_keyboard_t *);
+    void (*send_nkro)(report_nkro_t *);
+    void (*send_mouse)(report_mouse_t *);
+    void (*send_extra)(report_extra_t *);
+} host_driver_t;
+
+void           host_set_driver(host_driver_t *driver);
+host_driver_t *host_get_driver(void);
+void           host_keyboard_send(report_keyboard_t *report);
+void           host_nkro_send(report_nkro_t *report);
+void           host_consumer_send(uint16_t usage);
+
+// ---------------------------------------------------------------------------
+// Raw HID (raw_hid.h)
+
+#define RAW_EPSIZE 32
+
+void raw_hid_send(uint8_t *data, uint8_t length);
+
+// ---------------------------------------------------------------------------
+// EEPROM (eeprom.h, eeconfig.h) — in memory, and like the real thing it keeps its
+// contents across sim_reset(). Addresses are offsets into the simulated EEPROM.
+
+#define SIM_EEPROM_SIZE 1024
+#define EECONFIG_DEFAULT_LAYER ((uint8_t *)2)
+#ifdef EECONFIG_USER_DATA_SIZE
+#    define EECONFIG_USER_DATABLOCK ((uint8_t *)64)
+#endif
+
+void    eeprom_read_block(void *buf, const void *addr, size_t len);
+void    eeprom_update_block(const void *buf, void *addr, size_t len);
+uint8_t eeconfig_read_default_layer(void);
+void    eeconfig_update_default_layer(uint8_t val);
+
+// ---------------------------------------------------------------------------
+// Timer (timer.h) — driven by the simulator's virtual clock
+
+uint16_t timer_read(void);
+uint32_t timer_read32(void);
+uint16_t timer_elapsed(uint16_t last);
+uint32_t timer_elapsed32(uint32_t last);
+#define TIMER_DIFF_16(a, b) (uint16_t)((a) - (b))
+#define TIMER_DIFF_32(a, b) (uint32_t)((a) - (b))
+
+// ---------------------------------------------------------------------------
+// RGB matrix (rgb_matrix.h)
+
+typedef struct {
+    uint8_t r, g, b;
+} rgb_t;
+
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue);
+void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue);
+bool rgb_matrix_is_enabled(void);
+void rgb_matrix_enable_noeeprom(void);
+void rgb_matrix_disable_noeeprom(void);
+
+// ---------------------------------------------------------------------------
+// User hooks (defined weak in qmk_stub.c; keymap.c overrides what it needs)
+
+void          keyboard_post_init_user(void);
+void          suspend_power_down_user(void);
+void          suspend_wakeup_init_user(void);
+bool          pre_process_record_user(uint16_t keycode, keyrecord_t *record);
+bool          process_record_user(uint16_t keycode, keyrecord_t *record);
+uint16_t      get_tapping_term(uint16_t keycode, keyrecord_t *record);
+layer_state_t layer_state_set_user(layer_state_t state);
+void          housekeeping_task_user(void);
+void          matrix_scan_user(void);
+void          raw_hid_receive(uint8_t *data, uint8_t length);
+bool          rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max);
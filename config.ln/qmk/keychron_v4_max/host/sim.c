@@ -0,0 +1,651 @@
+// Scan loop, tap/hold arbitration, default key actions, RGB task and the
+// recording transport for the host simulator. See sim.h.
+
+#include "sim.h"
+#include "adaptive_tapping.h"
+#include "fast_wake.h"
+#include "latency_trace.h"
+#include "overrides.h"
+#include "report_queue.h"
+#include "rgb_power.h"
+#include "typing_streak.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+// ---------------------------------------------------------------------------
+// Physical key names, indexed like the matrix (see LAYOUT_ansi_61)
+
+// clang-format off
+static const char *const key_names[MATRIX_ROWS][MATRIX_COLS] = {
+    {"ESC",  "1",    "2",    "3", "4", "5", "6",   "7", "8", "9", "0",    "MINS", "EQL",  "BSPC"},
+    {"TAB",  "Q",    "W",    "E", "R", "T", "Y",   "U", "I", "O", "P",    "LBRC", "RBRC", "BSLS"},
+    {"CAPS", "A",    "S",    "D", "F", "G", "H",   "J", "K", "L", "SCLN", "QUOT", NULL,   "ENT"},
+    {"LSFT", NULL,   "Z",    "X", "C", "V", "B",   "N", "M", "COMM", "DOT", "SLSH", NULL, "RSFT"},
+    {"LCTL", "LALT", "LGUI", NULL, NULL, NULL, "SPC", NULL, NULL, NULL, "RGUI", "FN1", "FN2", "RCTL"},
+};
+// clang-format on
+
+bool sim_key_lookup(const char *name, keypos_t *key) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (key_names[row][col] && strcmp(key_names[row][col], name) == 0) {
+                *key = (keypos_t){.col = col, .row = row};
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+const char *sim_key_name(keypos_t key) {
+    const char *name = key.row < MATRIX_ROWS && key.col < MATRIX_COLS ? key_names[key.row][key.col] : NULL;
+    return name ? name : "?";
+}
+
+const char *sim_keycode_name(uint8_t code) {
+    static char buf[8];
+    static const char *const punctuation[] = {"ENT", "ESC", "BSPC", "TAB", "SPC", "MINS", "EQL", "LBRC", "RBRC", "BSLS", "NUHS", "SCLN", "QUOT", "GRV", "COMM", "DOT", "SLSH", "CAPS"};
+    static const char *const navigation[]  = {"HOME", "PGUP", "DEL", "END", "PGDN", "RGHT", "LEFT", "DOWN", "UP"};
+    static const char *const modifiers[]   = {"LCTL", "LSFT", "LALT", "LGUI", "RCTL", "RSFT", "RALT", "RGUI"};
+
+    if (code >= KC_A && code <= KC_Z) {
+        buf[0] = 'A' + (code - KC_A);
+        buf[1] = '\0';
+    } else if (code >= KC_1 && code <= KC_0) {
+        buf[0] = code == KC_0 ? '0' : '1' + (code - KC_1);
+        buf[1] = '\0';
+    } else if (code >= KC_ENTER && code <= KC_CAPS_LOCK) {
+        return punctuation[code - KC_ENTER];
+    } else if (code >= KC_HOME && code <= KC_UP) {
+        return navigation[code - KC_HOME];
+    } else if (IS_MODIFIER_KEYCODE(code)) {
+        return modifiers[code - KC_LEFT_CTRL];
+    } else {
+        snprintf(buf, sizeof(buf), "0x%02X", code);
+    }
+    return buf;
+}
+
+// ---------------------------------------------------------------------------
+// Hook timings
+
+static sim_timing_t timings[SIM_HOOK_COUNT];
+
+uint64_t sim_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void sim_timing_add(sim_hook_t hook, uint64_t ns) {
+    timings[hook].calls++;
+    timings[hook].total_ns += ns;
+    if (ns > timings[hook].max_ns) {
+        timings[hook].max_ns = ns;
+    }
+}
+
+const sim_timing_t *sim_timing(sim_hook_t hook) {
+    return &timings[hook];
+}
+
+const char *sim_hook_name(sim_hook_t hook) {
+    static const char *const names[SIM_HOOK_COUNT] = {
+        [SIM_HOOK_PRE_PROCESS_RECORD] = "pre_process_record_user",
+        [SIM_HOOK_PROCESS_RECORD]     = "process_record_user",
+        [SIM_HOOK_LAYER_STATE_SET]    = "layer_state_set_user",
+        [SIM_HOOK_RGB_INDICATORS]     = "rgb_matrix_indicators_advanced_user",
+        [SIM_HOOK_HOUSEKEEPING]       = "housekeeping_task_user",
+        [SIM_HOOK_POST_INIT]          = "keyboard_post_init_user",
+    };
+    return names[hook];
+}
+
+void sim_timing_reset(void) {
+    memset(timings, 0, sizeof(timings));
+}
+
+// ---------------------------------------------------------------------------
+// Recording transport
+
+static sim_report_t reports[SIM_LOG_MAX];
+static size_t       report_total;
+static sim_frame_t  frames[SIM_LOG_MAX];
+static size_t       frame_total;
+static uint64_t     now_us;
+static bool         transport_ready = true;
+
+// Like the wireless driver while it reconnects: reports are dropped
+void sim_set_transport_ready(bool ready) {
+    transport_ready = ready;
+}
+
+bool fast_wake_transport_ready(void) {
+    return transport_ready;
+}
+
+static sim_report_t *next_report(sim_report_kind_t kind) {
+    sim_report_t *slot = report_total < SIM_LOG_MAX ? &reports[report_total] : NULL;
+    report_total++;
+    if (slot) {
+        memset(slot, 0, sizeof(*slot));
+        slot->time_us = now_us;
+        slot->kind    = kind;
+    }
+    return slot;
+}
+
+static uint8_t transport_keyboard_leds(void) {
+    return 0;
+}
+
+static void transport_send_keyboard(report_keyboard_t *report) {
+    if (!transport_ready) return;
+    sim_report_t *slot = next_report(SIM_REPORT_KEYBOARD);
+    if (slot) slot->keyboard = *report;
+}
+
+static void transport_send_nkro(report_nkro_t *report) {
+    if (!transport_ready) return;
+    sim_report_t *slot = next_report(SIM_REPORT_NKRO);
+    if (slot) slot->nkro = *report;
+}
+
+static void transport_send_mouse(report_mouse_t *report) {}
+
+static void transport_send_extra(report_extra_t *report) {
+    if (!transport_ready) return;
+    sim_report_t *slot = next_report(SIM_REPORT_EXTRA);
+    if (slot) slot->extra = *report;
+}
+
+host_driver_t sim_transport = {
+    .keyboard_leds = transport_keyboard_leds,
+    .send_keyboard = transport_send_keyboard,
+    .send_nkro     = transport_send_nkro,
+    .send_mouse    = transport_send_mouse,
+    .send_extra    = transport_send_extra,
+};
+
+size_t sim_report_count(void) {
+    return report_total;
+}
+
+const sim_report_t *sim_report(size_t index) {
+    return index < report_total && index < SIM_LOG_MAX ? &reports[index] : NULL;
+}
+
+size_t sim_frame_count(void) {
+    return frame_total;
+}
+
+const sim_frame_t *sim_frame(size_t index) {
+    return index < frame_total && index < SIM_LOG_MAX ? &frames[index] : NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Keymap lookup (keymap_common.c)
+
+static uint16_t press_keycode[MATRIX_ROWS][MATRIX_COLS];
+
+static uint16_t keymap_keycode_at(keypos_t key) {
+    layer_state_t layers = layer_state | default_layer_state;
+    for (int8_t layer = keymap_layer_count() - 1; layer >= 0; layer--) {
+        if (layers & ((layer_state_t)1 << layer)) {
+            uint16_t keycode = keymaps[layer][key.row][key.col];
+            if (keycode != KC_TRANSPARENT) {
+                return keycode;
+            }
+        }
+    }
+    // layer_switch_get_layer() falls back to layer 0
+    return keymaps[0][key.row][key.col];
+}
+
+// Presses resolve through the active layers; releases reuse the keycode the
+// press resolved to, so a layer change in between cannot strand a key.
+static uint16_t record_keycode(const keyrecord_t *record) {
+    keypos_t key = record->event.key;
+    if (record->event.pressed) {
+        press_keycode[key.row][key.col] = keymap_keycode_at(key);
+    }
+    return press_keycode[key.row][key.col];
+}
+
+static bool is_tap_hold(uint16_t keycode) {
+    return IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode);
+}
+
+// ---------------------------------------------------------------------------
+// Default key actions (action.c)
+
+static uint8_t mod_tap_bits(uint16_t keycode) {
+    uint8_t mods = QK_MOD_TAP_GET_MODS(keycode);
+    return (mods & 0x10) ? (uint8_t)((mods & 0x0F) << 4) : mods;
+}
+
+static void process_action(uint16_t keycode, keyrecord_t *record) {
+    bool pressed = record->event.pressed;
+
+    if (keycode <= KC_TRANSPARENT) {
+        return;
+    } else if (keycode <= QK_BASIC_MAX) {
+        if (pressed) {
+            register_code(keycode);
+        } else {
+            unregister_code(keycode);
+        }
+    } else if (IS_QK_MOD_TAP(keycode)) {
+        if (record->tap.count > 0) {
+            if (pressed) {
+                register_code(QK_MOD_TAP_GET_TAP_KEYCODE(keycode));
+            } else {
+                unregister_code(QK_MOD_TAP_GET_TAP_KEYCODE(keycode));
+            }
+        } else {
+            if (pressed) {
+                add_mods(mod_tap_bits(keycode));
+            } else {
+                del_mods(mod_tap_bits(keycode));
+            }
+            send_keyboard_report();
+        }
+    } else if (IS_QK_LAYER_TAP(keycode)) {
+        if (record->tap.count > 0) {
+            if (pressed) {
+                register_code(QK_LAYER_TAP_GET_TAP_KEYCODE(keycode));
+            } else {
+                unregister_code(QK_LAYER_TAP_GET_TAP_KEYCODE(keycode));
+            }
+        } else if (pressed) {
+            layer_on(QK_LAYER_TAP_GET_LAYER(keycode));
+        } else {
+            layer_off(QK_LAYER_TAP_GET_LAYER(keycode));
+        }
+    } else if (IS_QK_MOMENTARY(keycode)) {
+        if (pressed) {
+            layer_on(keycode & 0x1F);
+        } else {
+            layer_off(keycode & 0x1F);
+        }
+    } else if (IS_QK_TO(keycode)) {
+        if (pressed) {
+            layer_move(keycode & 0x1F);
+        }
+    }
+}
+
+static void process_record(keyrecord_t *record) {
+    uint16_t keycode = record_keycode(record);
+    bool     proceed;
+    SIM_TIMED(SIM_HOOK_PROCESS_RECORD, proceed = process_record_user(keycode, record));
+    if (proceed) {
+        process_action(keycode, record);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Tap/hold arbitration (action_tapping.c)
+
+#define WAITING_BUFFER_SIZE 8
+
+static bool        tapping_active;
+static keyrecord_t tapping_record;
+static uint16_t    tapping_keycode;
+static keyrecord_t waiting_buffer[WAITING_BUFFER_SIZE];
+static uint8_t     waiting_count;
+
+static void process_tapping(keyrecord_t *record);
+
+static bool same_key(keypos_t a, keypos_t b) {
+    return a.row == b.row && a.col == b.col;
+}
+
+static uint16_t tapping_term(void) {
+#ifdef TAPPING_TERM_PER_KEY
+    return get_tapping_term(tapping_keycode, &tapping_record);
+#else
+    return TAPPING_TERM;
+#endif
+}
+
+static void replay_waiting(void) {
+    keyrecord_t pending[WAITING_BUFFER_SIZE];
+    uint8_t     count = waiting_count;
+    memcpy(pending, waiting_buffer, sizeof(pending));
+    waiting_count = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        process_tapping(&pending[i]);
+    }
+}
+
+static void resolve_hold(void) {
+    tapping_active           = false;
+    tapping_record.tap.count = 0;
+    process_record(&tapping_record);
+}
+
+static void resolve_tap(keyrecord_t *release) {
+    tapping_active           = false;
+    tapping_record.tap.count = 1;
+    process_record(&tapping_record);
+    release->tap.count = 1;
+    process_record(release);
+}
+
+static bool waiting_has_press(keypos_t key) {
+    for (uint8_t i = 0; i < waiting_count; i++) {
+        if (same_key(waiting_buffer[i].event.key, key) && waiting_buffer[i].event.pressed) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void buffer_event(keyrecord_t *record) {
+    if (waiting_count < WAITING_BUFFER_SIZE) {
+        waiting_buffer[waiting_count++] = *record;
+    }
+}
+
+static void process_tapping(keyrecord_t *record) {
+    keyevent_t *event = &record->event;
+
+    if (tapping_active) {
+        uint16_t elapsed = TIMER_DIFF_16(event->time, tapping_record.event.time);
+
+        if (event->type == TICK_EVENT) {
+            if (elapsed >= tapping_term()) {
+                resolve_hold();
+                replay_waiting();
+            }
+        } else if (same_key(event->key, tapping_record.event.key)) {
+            // Release of the tap/hold key itself
+            if (elapsed < tapping_term()) {
+                resolve_tap(record);
+            } else {
+                resolve_hold();
+                process_record(record);
+            }
+            replay_waiting();
+        } else if (event->pressed) {
+#ifdef HOLD_ON_OTHER_KEY_PRESS
+            resolve_hold();
+            replay_waiting();
+            process_tapping(record);
+#else
+            buffer_event(record);
+#endif
+        } else if (waiting_has_press(event->key)) {
+#ifdef PERMISSIVE_HOLD
+            buffer_event(record);
+            resolve_hold();
+            replay_waiting();
+#else
+            buffer_event(record);
+#endif
+        } else {
+            // Release of a key pressed before the tap/hold key: not ours to hold back
+            process_record(record);
+        }
+        return;
+    }
+
+    if (event->type == KEY_EVENT && event->pressed && is_tap_hold(keymap_keycode_at(event->key))) {
+        tapping_active  = true;
+        tapping_record  = *record;
+        tapping_keycode = keymap_keycode_at(event->key);
+        return;
+    }
+    if (event->type == KEY_EVENT) {
+        process_record(record);
+    }
+}
+
+// pre_process_record_user() sees every key event before tap/hold arbitration
+// and can swallow it (action.c, pre_process_record_quantum).
+static void action_exec(keyevent_t event) {
+    keyrecord_t record = {.event = event};
+    if (event.type == KEY_EVENT) {
+        uint16_t keycode = record_keycode(&record);
+        bool     proceed;
+        SIM_TIMED(SIM_HOOK_PRE_PROCESS_RECORD, proceed = pre_process_record_user(keycode, &record));
+        if (!proceed) {
+            return;
+        }
+    }
+    process_tapping(&record);
+}
+
+// ---------------------------------------------------------------------------
+// RGB matrix task (rgb_matrix.c): one chunk per scan, flush at most every
+// RGB_MATRIX_LED_FLUSH_LIMIT ms.
+
+rgb_t sim_led_buffer[RGB_MATRIX_LED_COUNT];
+
+static rgb_t    flushed[RGB_MATRIX_LED_COUNT];
+static bool     flushed_valid;
+static uint8_t  rgb_iter;
+static uint64_t rgb_frame_start_us;
+
+static void rgb_flush(void) {
+    if (flushed_valid && memcmp(flushed, sim_led_buffer, sizeof(flushed)) == 0) {
+        return;
+    }
+    memcpy(flushed, sim_led_buffer, sizeof(flushed));
+    flushed_valid = true;
+
+    sim_frame_t *slot = frame_total < SIM_LOG_MAX ? &frames[frame_total] : NULL;
+    frame_total++;
+    if (slot) {
+        slot->time_us = now_us;
+        memcpy(slot->leds, sim_led_buffer, sizeof(slot->leds));
+    }
+}
+
+static void rgb_matrix_task(void) {
+    if (rgb_iter == 0) {
+        if (now_us - rgb_frame_start_us < RGB_MATRIX_LED_FLUSH_LIMIT * 1000u && flushed_valid) {
+            return;
+        }
+        rgb_frame_start_us = now_us;
+        if (!rgb_matrix_is_enabled()) {
+            memset(sim_led_buffer, 0, sizeof(sim_led_buffer));
+            rgb_flush();
+            return;
+        }
+        // RGB_MATRIX_SOLID_COLOR at the configured startup value
+        rgb_matrix_set_color_all(RGB_MATRIX_STARTUP_VAL, RGB_MATRIX_STARTUP_VAL, RGB_MATRIX_STARTUP_VAL);
+    }
+
+    uint8_t led_min = rgb_iter * RGB_MATRIX_LED_PROCESS_LIMIT;
+    uint8_t led_max = MIN(led_min + RGB_MATRIX_LED_PROCESS_LIMIT, RGB_MATRIX_LED_COUNT);
+    SIM_TIMED(SIM_HOOK_RGB_INDICATORS, rgb_matrix_indicators_advanced_user(led_min, led_max));
+
+    if (led_max == RGB_MATRIX_LED_COUNT) {
+        rgb_iter = 0;
+        rgb_flush();
+    } else {
+        rgb_iter++;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Raw HID: raw_hid_send() lands here and is handed back by sim_raw_hid()
+
+static uint8_t raw_hid_response[RAW_EPSIZE];
+static bool    raw_hid_responded;
+
+void raw_hid_send(uint8_t *data, uint8_t length) {
+    memcpy(raw_hid_response, data, MIN(length, (uint8_t)RAW_EPSIZE));
+    raw_hid_responded = true;
+}
+
+bool sim_raw_hid(uint8_t packet[RAW_EPSIZE]) {
+    raw_hid_responded = false;
+    raw_hid_receive(packet, RAW_EPSIZE);
+    if (raw_hid_responded) {
+        memcpy(packet, raw_hid_response, RAW_EPSIZE);
+    }
+    return raw_hid_responded;
+}
+
+// ---------------------------------------------------------------------------
+// Scan loop
+
+#define PENDING_MAX 16
+
+static uint32_t     scan_interval_us = SIM_DEFAULT_SCAN_US;
+static keyevent_t   pending[PENDING_MAX];
+static uint8_t      pending_count;
+static matrix_row_t matrix[MATRIX_ROWS];
+
+uint64_t sim_now_us(void) {
+    return now_us;
+}
+
+#ifdef LATENCY_TRACE_ENABLE
+// Trace in virtual microseconds (LATENCY_TRACE_CLOCK_HZ is 1 MHz off-target)
+uint32_t latency_trace_clock(void) {
+    return (uint32_t)now_us;
+}
+#endif
+
+// Background task budgets (sched.h) in virtual microseconds too
+uint32_t sched_clock(void) {
+    return (uint32_t)now_us;
+}
+
+void sim_advance_us(uint32_t us) {
+    now_us += us;
+}
+
+matrix_row_t matrix_get_row(uint8_t row) {
+    return row < MATRIX_ROWS ? matrix[row] : 0;
+}
+
+void sim_set_scan_interval_us(uint32_t us) {
+    scan_interval_us = us;
+}
+
+void sim_key(keypos_t key, bool pressed) {
+    if (pending_count < PENDING_MAX) {
+        pending[pending_count++] = (keyevent_t){.key = key, .pressed = pressed, .type = KEY_EVENT};
+    }
+}
+
+void sim_scan(void) {
+    // matrix_scan(): the debounced matrix changes, then matrix_scan_user()
+    for (uint8_t i = 0; i < pending_count; i++) {
+        matrix_row_t bit = (matrix_row_t)1 << pending[i].key.col;
+        if (pending[i].pressed) {
+            matrix[pending[i].key.row] |= bit;
+        } else {
+            matrix[pending[i].key.row] &= ~bit;
+        }
+    }
+    matrix_scan_user();
+
+    if (pending_count == 0) {
+        action_exec((keyevent_t){.type = TICK_EVENT, .time = timer_read()});
+    }
+    for (uint8_t i = 0; i < pending_count; i++) {
+        pending[i].time = timer_read();
+        action_exec(pending[i]);
+    }
+    pending_count = 0;
+
+    SIM_TIMED(SIM_HOOK_HOUSEKEEPING, housekeeping_task_user());
+    rgb_matrix_task();
+    now_us += scan_interval_us;
+}
+
+void sim_run_ms(uint32_t ms) {
+    uint64_t until = now_us + (uint64_t)ms * 1000u;
+    while (now_us < until) {
+        sim_scan();
+    }
+}
+
+void sim_reset(void) {
+    qmk_stub_reset();
+    host_set_driver(&sim_transport);
+
+    now_us             = 0;
+    transport_ready    = true;
+    report_total       = 0;
+    frame_total        = 0;
+    pending_count      = 0;
+    tapping_active     = false;
+    waiting_count      = 0;
+    rgb_iter           = 0;
+    rgb_frame_start_us = 0;
+    flushed_valid      = false;
+    memset(press_keycode, 0, sizeof(press_keycode));
+    memset(matrix, 0, sizeof(matrix));
+    memset(sim_led_buffer, 0, sizeof(sim_led_buffer));
+
+    // The keymap modules' RAM, which a power-on clears; EEPROM stays
+    adaptive_tapping_reset();
+    fast_wake_reset();
+    overrides_reset();
+    typing_streak_reset();
+#ifdef REPORT_QUEUE_ENABLE
+    report_queue_reset();
+#endif
+#ifdef RGB_MATRIX_ENABLE
+    rgb_power_reset();  // after the clock restarts: idle time counts from now
+#endif
+
+    // magic.c: the default layer comes from EEPROM before the keymap's init
+    default_layer_set((layer_state_t)eeconfig_read_default_layer());
+    SIM_TIMED(SIM_HOOK_POST_INIT, keyboard_post_init_user());
+}
+
+// ---------------------------------------------------------------------------
+// Trace replay
+//
+//   down KEY     press a key (physical name, see key_names)
+//   up KEY       release a key
+//   wait MS      run scans for MS milliseconds
+//   # ...        comment
+//
+// Presses and releases between two waits land in the same scan cycle.
+
+int sim_replay(FILE *trace) {
+    char line[128];
+    int  lineno = 0;
+
+    while (fgets(line, sizeof(line), trace)) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char verb[16], arg[16];
+        int  fields = sscanf(line, "%15s %15s", verb, arg);
+        if (fields <= 0) {
+            continue;
+        }
+        if (fields != 2) {
+            return lineno;
+        }
+
+        keypos_t key;
+        if (strcmp(verb, "wait") == 0) {
+            char *end;
+            long  ms = strtol(arg, &end, 10);
+            if (*end || ms < 0) return lineno;
+            sim_run_ms((uint32_t)ms);
+        } else if ((strcmp(verb, "down") == 0 || strcmp(verb, "up") == 0) && sim_key_lookup(arg, &key)) {
+            sim_key(key, verb[0] == 'd');
+        } else {
+            return lineno;
+        }
+    }
+    // Let anything queued by the last lines reach the keymap
+    if (pending_count) {
+        sim_scan();
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Host-side keyboard simulator for keymap.c.
+//
+// Drives the keymap the way QMK's keyboard_task() does: every scan cycle the
+// matrix changes go through tap/hold arbitration (action_tapping.c semantics for
+// the options set in config.h) into process_record_user and the default key
+// actions, housekeeping runs, and the RGB matrix renders one LED chunk. Time is
+// virtual; hook CPU cost is measured with the real monotonic clock.
+
+#pragma once
+
+#include <stdio.h>
+
+#include "qmk_stub.h"
+
+// ---------------------------------------------------------------------------
+// Virtual clock and scan loop
+
+#define SIM_DEFAULT_SCAN_US 1000
+
+uint64_t sim_now_us(void);
+void     sim_set_scan_interval_us(uint32_t us);
+
+// Moves the virtual clock within a scan: the time a piece of keymap code takes,
+// for tests of code that measures itself (sched.h budgets).
+void sim_advance_us(uint32_t us);
+
+// Resets keymap-visible QMK state and the keymap modules' RAM, installs the
+// recording transport and runs keyboard_post_init_user(), like a power-on.
+void sim_reset(void);
+
+// Queues a matrix change; it is picked up by the next scan.
+void sim_key(keypos_t key, bool pressed);
+
+// One keyboard_task() iteration, then advance the clock by one scan interval.
+void sim_scan(void);
+
+// Scan until `ms` milliseconds of virtual time have passed.
+void sim_run_ms(uint32_t ms);
+
+// Replays a trace file (format in sim.c). Returns 0, or the failing line number.
+int sim_replay(FILE *trace);
+
+// Physical key names ("CAPS", "A", "FN1", ...) as printed on the stock keycaps.
+bool        sim_key_lookup(const char *name, keypos_t *key);
+const char *sim_key_name(keypos_t key);
+const char *sim_keycode_name(uint8_t code);
+
+uint8_t keymap_layer_count(void);
+
+// ---------------------------------------------------------------------------
+// Recorded output
+
+#define SIM_LOG_MAX 4096
+
+typedef enum {
+    SIM_REPORT_NKRO,
+    SIM_REPORT_KEYBOARD,
+    SIM_REPORT_EXTRA,
+} sim_report_kind_t;
+
+typedef struct {
+    uint64_t          time_us;
+    sim_report_kind_t kind;
+    union {
+        report_nkro_t     nkro;
+        report_keyboard_t keyboard;
+        report_extra_t    extra;
+    };
+} sim_report_t;
+
+typedef struct {
+    uint64_t time_us;
+    rgb_t    leds[RGB_MATRIX_LED_COUNT];
+} sim_frame_t;
+
+// Totals keep counting past SIM_LOG_MAX; only the first entries are stored.
+size_t              sim_report_count(void);
+const sim_report_t *sim_report(size_t index);
+size_t              sim_frame_count(void);
+const sim_frame_t  *sim_frame(size_t index);
+
+// The transport installed by sim_reset(); records every report it is handed
+// while ready (the default), drops them otherwise, like Bluetooth reconnecting.
+extern host_driver_t sim_transport;
+void                 sim_set_transport_ready(bool ready);
+
+// LED colors written during the current frame (rgb_matrix_set_color target).
+extern rgb_t sim_led_buffer[RGB_MATRIX_LED_COUNT];
+
+// Hands `packet` to raw_hid_receive(); if the keymap answered with
+// raw_hid_send(), the answer replaces `packet` and true is returned.
+bool sim_raw_hid(uint8_t packet[RAW_EPSIZE]);
+
+// ---------------------------------------------------------------------------
+// Hook timings
+
+typedef enum {
+    SIM_HOOK_PRE_PROCESS_RECORD,
+    SIM_HOOK_PROCESS_RECORD,
+    SIM_HOOK_LAYER_STATE_SET,
+    SIM_HOOK_RGB_INDICATORS,
+    SIM_HOOK_HOUSEKEEPING,
+    SIM_HOOK_POST_INIT,
+    SIM_HOOK_COUNT,
+} sim_hook_t;
+
+typedef struct {
+    uint32_t calls;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} sim_timing_t;
+
+uint64_t            sim_clock_ns(void);
+void                sim_timing_add(sim_hook_t hook, uint64_t ns);
+const sim_timing_t *sim_timing(sim_hook_t hook);
+const char         *sim_hook_name(sim_hook_t hook);
+void                sim_timing_reset(void);
+
+#define SIM_TIMED(hook, expr)                                      \
+    do {                                                           \
+        uint64_t sim_timed_start_ = sim_clock_ns();                \
+        expr;                                                      \
+        sim_timing_add((hook), sim_clock_ns() - sim_timed_start_); \
+    } while (0)
+
+// Provided by qmk_stub.c
+void qmk_stub_reset(void);
+
+// The simulated EEPROM (qmk_stub.h). sim_eeprom_erase() returns it to a freshly
+// initialised eeconfig (all zero); sim_eeprom_writes() counts block updates that
+// changed at least one byte.
+uint8_t *sim_eeprom(void);
+uint32_t sim_eeprom_writes(void);
+void     sim_eeprom_erase(void);
@@ -0,0 +1,142 @@
+// keymap_sim: replay a key trace through keymap.c and print what the keyboard
+// would have sent and shown.
+//
+//   keymap_sim [-t] TRACE
+//
+//   -t   also print per-hook CPU timings (not deterministic; off for golden tests)
+//        and the report queue counters
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim.h"
+#ifdef REPORT_QUEUE_ENABLE
+#    include "report_queue.h"
+#endif
+
+static void print_time(uint64_t us) {
+    printf("%6llu.%03llu ", (unsigned long long)(us / 1000), (unsigned long long)(us % 1000));
+}
+
+static void print_mods(uint8_t mods) {
+    static const char *const names[8] = {"LCTL", "LSFT", "LALT", "LGUI", "RCTL", "RSFT", "RALT", "RGUI"};
+    bool                     first    = true;
+    for (uint8_t i = 0; i < 8; i++) {
+        if (mods & (1 << i)) {
+            printf("%s%s", first ? "" : "+", names[i]);
+            first = false;
+        }
+    }
+    if (first) printf("-");
+}
+
+static void print_report(const sim_report_t *report) {
+    print_time(report->time_us);
+    switch (report->kind) {
+        case SIM_REPORT_NKRO:
+            printf("report   mods=");
+            print_mods(report->nkro.mods);
+            printf(" keys=");
+            bool any = false;
+            for (unsigned code = 0; code < NKRO_REPORT_BITS * 8; code++) {
+                if (report->nkro.bits[code >> 3] & (1 << (code & 7))) {
+                    printf("%s%s", any ? "," : "", sim_keycode_name(code));
+                    any = true;
+                }
+            }
+            if (!any) printf("-");
+            break;
+        case SIM_REPORT_KEYBOARD:
+            printf("report6  mods=");
+            print_mods(report->keyboard.mods);
+            printf(" keys=");
+            for (unsigned i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+                printf("%s%s", i ? "," : "", sim_keycode_name(report->keyboard.keys[i]));
+            }
+            break;
+        case SIM_REPORT_EXTRA:
+            printf("consumer usage=0x%04X", report->extra.usage);
+            break;
+    }
+    printf("\n");
+}
+
+// Frames print as runs of equal color: "0-29=000000 30-31=020020 ..."
+static void print_frame(const sim_frame_t *frame) {
+    print_time(frame->time_us);
+    printf("leds    ");
+    for (int start = 0; start < RGB_MATRIX_LED_COUNT;) {
+        rgb_t c   = frame->leds[start];
+        int   end = start;
+        while (end + 1 < RGB_MATRIX_LED_COUNT && memcmp(&frame->leds[end + 1], &c, sizeof(c)) == 0) {
+            end++;
+        }
+        if (end == start) {
+            printf(" %d=%02x%02x%02x", start, c.r, c.g, c.b);
+        } else {
+            printf(" %d-%d=%02x%02x%02x", start, end, c.r, c.g, c.b);
+        }
+        start = end + 1;
+    }
+    printf("\n");
+}
+
+static void print_timings(void) {
+    printf("\n%-38s %8s %10s %10s\n", "hook", "calls", "mean ns", "max ns");
+    for (sim_hook_t hook = 0; hook < SIM_HOOK_COUNT; hook++) {
+        const sim_timing_t *t = sim_timing(hook);
+        if (t->calls == 0) continue;
+        printf("%-38s %8u %10llu %10llu\n", sim_hook_name(hook), t->calls, (unsigned long long)(t->total_ns / t->calls), (unsigned long long)t->max_ns);
+    }
+#ifdef REPORT_QUEUE_ENABLE
+    const report_queue_stats_t *q = report_queue_stats();
+    printf("\nreports generated %u, sent %u, merged %u, dropped %u\n", q->generated, q->sent, q->merged, q->dropped);
+#endif
+}
+
+int main(int argc, char **argv) {
+    bool timings = false;
+    int  opt;
+    while ((opt = getopt(argc, argv, "t")) != -1) {
+        if (opt == 't') {
+            timings = true;
+        } else {
+            fprintf(stderr, "usage: %s [-t] TRACE\n", argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-t] TRACE\n", argv[0]);
+        return 2;
+    }
+
+    FILE *trace = fopen(argv[optind], "r");
+    if (!trace) {
+        perror(argv[optind]);
+        return 2;
+    }
+
+    sim_reset();
+    sim_timing_reset();
+    int bad_line = sim_replay(trace);
+    fclose(trace);
+    if (bad_line) {
+        fprintf(stderr, "%s:%d: cannot parse trace line\n", argv[optind], bad_line);
+        return 2;
+    }
+
+    // Interleave reports and frames by time
+    size_t r = 0, f = 0;
+    size_t nr = MIN(sim_report_count(), (size_t)SIM_LOG_MAX), nf = MIN(sim_frame_count(), (size_t)SIM_LOG_MAX);
+    while (r < nr || f < nf) {
+        if (f >= nf || (r < nr && sim_report(r)->time_us <= sim_frame(f)->time_us)) {
+            print_report(sim_report(r++));
+        } else {
+            print_frame(sim_frame(f++));
+        }
+    }
+    if (timings) {
+        print_timings();
+    }
+    return 0;
+}
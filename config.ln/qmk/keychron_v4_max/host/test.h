@@ -0,0 +1,64 @@
+// Tiny assertion helpers for the host unit tests (test_*.c). Each test file is
+// its own executable; `make test` runs them all.
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+static int test_failures;
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                                         \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                                                 \
+    do {                                                                                                                           \
+        long long test_a_ = (long long)(actual), test_e_ = (long long)(expected);                                                  \
+        if (test_a_ != test_e_) {                                                                                                  \
+            fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, test_a_, test_e_); \
+            test_failures++;                                                                                                       \
+        }                                                                                                                          \
+    } while (0)
+
+#define TEST_DONE()                                                                \
+    do {                                                                           \
+        if (test_failures) fprintf(stderr, "%d check(s) failed\n", test_failures); \
+        return test_failures ? 1 : 0;                                              \
+    } while (0)
+
+// Press or release a key by its physical name and let one scan pick it up.
+static inline void test_key(const char *name, bool pressed) {
+    keypos_t key;
+    if (!sim_key_lookup(name, &key)) {
+        fprintf(stderr, "unknown key %s\n", name);
+        exit(2);
+    }
+    sim_key(key, pressed);
+}
+
+// Down, hold for `ms`, up, then let the keyboard settle.
+static inline void test_tap(const char *name, uint32_t ms) {
+    test_key(name, true);
+    sim_run_ms(ms);
+    test_key(name, false);
+    sim_run_ms(50);
+}
+
+// Index of the first NKRO report at or after `from` with `code` down and all of
+// `mods` held, or -1.
+static inline long test_find_report(size_t from, uint8_t code, uint8_t mods) {
+    for (size_t i = from; i < sim_report_count() && i < SIM_LOG_MAX; i++) {
+        const sim_report_t *r = sim_report(i);
+        if (r->kind == SIM_REPORT_NKRO && (r->nkro.mods & mods) == mods && (code == KC_NO || (r->nkro.bits[code >> 3] & (1 << (code & 7))))) {
+            return (long)i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,117 @@
+// Adaptive tapping term: the window follows recent taps, missed taps grow it
+// back, and chorded holds still resolve immediately.
+
+#include "test.h"
+#include "adaptive_tapping.h"
+
+static void test_term_follows_taps(void) {
+    adaptive_tapping_reset();
+    CHECK_EQ(adaptive_tapping_term(TAP_SLOT_ESC_CTRL, 175), 175);
+
+    static const uint16_t taps[] = {60, 95, 70, 80};
+    uint16_t              t      = 1000;
+    for (size_t i = 0; i < ARRAY_SIZE(taps); i++) {
+        adaptive_tapping_press(TAP_SLOT_ESC_CTRL, t);
+        // Still learning until ADAPTIVE_TAPPING_MIN_SAMPLES taps are in
+        CHECK_EQ(adaptive_tapping_term(TAP_SLOT_ESC_CTRL, 175), 175);
+        adaptive_tapping_release(TAP_SLOT_ESC_CTRL, t + taps[i], true, 175);
+        t += 500;
+    }
+    CHECK_EQ(adaptive_tapping_term(TAP_SLOT_ESC_CTRL, 175), 95 + ADAPTIVE_TAPPING_MARGIN);
+
+    // Other slots are independent
+    CHECK_EQ(adaptive_tapping_term(TAP_SLOT_ENT_CTRL, 175), 175);
+
+    // Never below the floor, never above the configured term
+    adaptive_tapping_reset();
+    for (int i = 0; i < ADAPTIVE_TAPPING_SAMPLES; i++) {
+        adaptive_tapping_press(TAP_SLOT_ENT_CTRL, 0);
+        adaptive_tapping_release(TAP_SLOT_ENT_CTRL, 20, true, 175);
+    }
+    CHECK_EQ(adaptive_tapping_term(TAP_SLOT_ENT_CTRL, 175), ADAPTIVE_TAPPING_MIN);
+    CHECK_EQ(adaptive_tapping_term(TAP_SLOT_ENT_CTRL, 100), 100);
+}
+
+static void test_ring_forgets_old_taps(void) {
+    adaptive_tapping_reset();
+    adaptive_tapping_press(TAP_SLOT_GRV_VIM, 0);
+    adaptive_tapping_release(TAP_SLOT_GRV_VIM, 150, true, 200);
+    for (int i = 0; i < ADAPTIVE_TAPPING_SAMPLES - 1; i++) {
+        adaptive_tapping_press(TAP_SLOT_GRV_VIM, 0);
+        adaptive_tapping_release(TAP_SLOT_GRV_VIM, 90, true, 200);
+    }
+    CHECK_EQ(adaptive_tapping_term(TAP_SLOT_GRV_VIM, 200), 150 + ADAPTIVE_TAPPING_MARGIN);
+    adaptive_tapping_press(TAP_SLOT_GRV_VIM, 0);
+    adaptive_tapping_release(TAP_SLOT_GRV_VIM, 90, true, 200);
+    CHECK_EQ(adaptive_tapping_term(TAP_SLOT_GRV_VIM, 200), 90 + ADAPTIVE_TAPPING_MARGIN);
+}
+
+static void test_holds(void) {
+    adaptive_tapping_reset();
+    for (int i = 0; i < ADAPTIVE_TAPPING_MIN_SAMPLES; i++) {
+        adaptive_tapping_press(TAP_SLOT_ESC_CTRL, 0);
+        adaptive_tapping_release(TAP_SLOT_ESC_CTRL, 50, true, 175);
+    }
+    CHECK_EQ(adaptive_tapping_term(TAP_SLOT_ESC_CTRL, 175), ADAPTIVE_TAPPING_MIN);
+
+    // Chorded hold (Ctrl+A): a real hold, not learned
+    adaptive_tapping_press(TAP_SLOT_ESC_CTRL, 0);
+    adaptive_tapping_other_key();
+    adaptive_tapping_release(TAP_SLOT_ESC_CTRL, 400, false, 175);
+    CHECK_EQ(adaptive_tapping_term(TAP_SLOT_ESC_CTRL, 175), ADAPTIVE_TAPPING_MIN);
+
+    // Lone hold well past the configured term (Ctrl + mouse click): a real hold
+    adaptive_tapping_press(TAP_SLOT_ESC_CTRL, 0);
+    adaptive_tapping_release(TAP_SLOT_ESC_CTRL, 600, false, 175);
+    CHECK_EQ(adaptive_tapping_term(TAP_SLOT_ESC_CTRL, 175), ADAPTIVE_TAPPING_MIN);
+
+    // Lonely hold: a tap that missed the shrunk window, so the window grows back
+    adaptive_tapping_press(TAP_SLOT_ESC_CTRL, 0);
+    adaptive_tapping_release(TAP_SLOT_ESC_CTRL, 130, false, 175);
+    CHECK_EQ(adaptive_tapping_term(TAP_SLOT_ESC_CTRL, 175), 130 + ADAPTIVE_TAPPING_MARGIN);
+}
+
+// End to end through keymap.c and the simulator's tap/hold arbitration.
+static void test_keymap(void) {
+#ifdef ADAPTIVE_TAPPING_TERM
+    sim_reset();
+
+    // Fast Esc taps shrink the Caps Lock window to the floor...
+    for (int i = 0; i < ADAPTIVE_TAPPING_SAMPLES; i++) {
+        test_tap("CAPS", 40);
+    }
+    CHECK_EQ(get_tapping_term(MT(MOD_LCTL, KC_ESC), NULL), ADAPTIVE_TAPPING_MIN);
+    CHECK_EQ(get_tapping_term(MT(MOD_RCTL, KC_ENT), NULL), TAPPING_TERM_ENT_CTRL);
+
+    // A lone Ctrl held over a mouse click is a real hold: the window stays
+    test_tap("CAPS", 500);
+    CHECK_EQ(get_tapping_term(MT(MOD_LCTL, KC_ESC), NULL), ADAPTIVE_TAPPING_MIN);
+
+    // ...so a lone 150 ms press is now Ctrl, not Esc
+    size_t from = sim_report_count();
+    test_tap("CAPS", 150);
+    CHECK_EQ(test_find_report(from, KC_ESC, 0), -1);
+    CHECK(test_find_report(from, KC_NO, MOD_BIT(KC_LCTL)) >= 0);
+    // and that missed tap widens the window again
+    CHECK_EQ(get_tapping_term(MT(MOD_LCTL, KC_ESC), NULL), TAPPING_TERM_ESC_CTRL);
+
+    // HOLD_ON_OTHER_KEY_PRESS still turns a chord into Ctrl+A right away
+    from = sim_report_count();
+    test_key("CAPS", true);
+    sim_run_ms(10);
+    test_key("A", true);
+    sim_run_ms(1);
+    CHECK(test_find_report(from, KC_A, MOD_BIT(KC_LCTL)) >= 0);
+    test_key("A", false);
+    test_key("CAPS", false);
+    sim_run_ms(50);
+#endif
+}
+
+int main(void) {
+    test_term_follows_taps();
+    test_ring_forgets_old_taps();
+    test_holds();
+    test_keymap();
+    TEST_DONE();
+}
@@ -0,0 +1,132 @@
+// Asymmetric debounce on synthetic bouncing samples: presses register on the
+// first closed sample, releases after a stable open window, chatter after a
+// release is counted and earns the key a longer window.
+
+#include <string.h>
+
+#include "test.h"
+#include "debounce_asym.h"
+
+#define ROW 2
+#define COL 3
+
+static matrix_row_t raw[MATRIX_ROWS], cooked[MATRIX_ROWS];
+
+static void start(void) {
+    sim_reset();
+    memset(raw, 0, sizeof(raw));
+    memset(cooked, 0, sizeof(cooked));
+    debounce_init(MATRIX_ROWS);
+}
+
+// One raw sample per ms for the key at ROW/COL ('1' closed, '0' open); checks
+// the cooked state after each sample against `expected`.
+static void feed(const char *samples, const char *expected, int line) {
+    char got[256] = {0};
+    for (size_t i = 0; samples[i] && i < sizeof(got) - 1; i++) {
+        raw[ROW] = samples[i] == '1' ? raw[ROW] | (1 << COL) : raw[ROW] & ~(1 << COL);
+        matrix_row_t before = cooked[ROW];
+        bool         changed = debounce(raw, cooked, MATRIX_ROWS, true);
+        if (changed != (before != cooked[ROW])) {
+            fprintf(stderr, "test_debounce_asym.c:%d: debounce() returned %d at sample %zu\n", line, changed, i);
+            test_failures++;
+        }
+        got[i] = cooked[ROW] & (1 << COL) ? '1' : '0';
+        sim_run_ms(1);
+    }
+    if (strcmp(got, expected) != 0) {
+        fprintf(stderr, "test_debounce_asym.c:%d: samples  %s\n  cooked   %s\n  expected %s\n", line, samples, got, expected);
+        test_failures++;
+    }
+}
+#define FEED(samples, expected) feed(samples, expected, __LINE__)
+
+static void test_clean(void) {
+    start();
+    // Press on the first sample; release after DEBOUNCE (5) open samples
+    FEED("0011111000000000",
+         "0011111111110000");
+}
+
+static void test_bounce(void) {
+    start();
+    // Press bounce is hidden behind the first edge
+    FEED("1010111111",
+         "1111111111");
+    // Release bounce: one release, DEBOUNCE after the last open edge
+    FEED("0101000000000",
+         "1111111110000");
+    CHECK_EQ(debounce_chatter_count(ROW, COL), 0);
+
+    // A blip inside the hold-off after a release is ignored
+    start();
+    FEED("11110000001100000000",
+         "11111111100000000000");
+}
+
+static void test_chatter(void) {
+    start();
+    CHECK_EQ(debounce_window(ROW, COL), DEBOUNCE);
+
+    // A worn switch closes again shortly after the release: that double types
+    // (unavoidable the first times) and is counted
+    for (int i = 0; i < DEBOUNCE_CHATTER_LIMIT - 1; i++) {
+        FEED("11100000000000" "11" "000000000000000000000000000000",
+             "11111111000000" "11" "111110000000000000000000000000");
+        CHECK_EQ(debounce_chatter_count(ROW, COL), i + 1);
+        CHECK_EQ(debounce_window(ROW, COL), DEBOUNCE);
+    }
+    // The last straw: that very press already gets the longer window
+    FEED("11100000000000" "11" "000000000000000000000000000000",
+         "11111111000000" "11" "111111111111111111110000000000");
+    CHECK_EQ(debounce_chatter_count(ROW, COL), DEBOUNCE_CHATTER_LIMIT);
+    CHECK_EQ(debounce_window(ROW, COL), DEBOUNCE_CHATTER_WINDOW);
+
+    // Flagged: the same chatter is swallowed by the longer release window
+    sim_run_ms(100);
+    FEED("11100000000000" "11" "000000000000000000000000000000",
+         "11111111111111" "11" "111111111111111111110000000000");
+    CHECK_EQ(debounce_chatter_count(ROW, COL), DEBOUNCE_CHATTER_LIMIT);
+
+    // Other keys are unaffected
+    CHECK_EQ(debounce_window(ROW, COL + 1), DEBOUNCE);
+    CHECK_EQ(debounce_chatter_count(ROW + 1, COL), 0);
+}
+
+static void test_fast_repeat_is_not_chatter(void) {
+    start();
+    // Double letter typed quickly: 40 ms between release and the next press
+    FEED("1111100000" "0000000000" "0000000000" "0000000000" "1111100000000",
+         "1111111111" "0000000000" "0000000000" "0000000000" "1111111111000");
+    CHECK_EQ(debounce_chatter_count(ROW, COL), 0);
+}
+
+static void test_independent_keys(void) {
+    start();
+    // Two keys in one row: one releasing while the other is pressed
+    raw[ROW] = 1 << COL;
+    debounce(raw, cooked, MATRIX_ROWS, true);
+    sim_run_ms(1);
+    raw[ROW] = 1 << (COL + 1);
+    CHECK(debounce(raw, cooked, MATRIX_ROWS, true));
+    CHECK_EQ(cooked[ROW], (1 << COL) | (1 << (COL + 1)));
+    for (int i = 0; i < DEBOUNCE; i++) {
+        sim_run_ms(1);
+        debounce(raw, cooked, MATRIX_ROWS, false);
+    }
+    CHECK_EQ(cooked[ROW], 1 << (COL + 1));
+
+    // Nothing moving: nothing to report
+    sim_run_ms(DEBOUNCE * 2);
+    CHECK(!debounce(raw, cooked, MATRIX_ROWS, false));
+    CHECK(!debounce(raw, cooked, MATRIX_ROWS, false));
+}
+
+int main(void) {
+    test_clean();
+    test_bounce();
+    test_chatter();
+    test_fast_repeat_is_not_chatter();
+    test_independent_keys();
+    TEST_DONE();
+}
@@ -0,0 +1,123 @@
+// Boot and wake: keys are handled from the first scan, the RGB matrix comes up
+// later in quiet scans, and a keystroke made while the transport reconnects
+// reaches the host once it is connected.
+
+#include "test.h"
+#include "fast_wake.h"
+
+static bool nkro_has(const sim_report_t *r, uint8_t code) {
+    return r->kind == SIM_REPORT_NKRO && (r->nkro.bits[code >> 3] & (1 << (code & 7)));
+}
+
+static void test_boot(void) {
+    sim_reset();
+    CHECK_EQ(fast_wake_phase(WAKE_INPUT_READY), 0);
+    CHECK(!rgb_matrix_is_enabled());
+
+    // A key pressed right at power-on goes out in the first scan
+    test_key("A", true);
+    sim_run_ms(1);
+    CHECK_EQ(sim_report_count(), 1);
+    CHECK(nkro_has(sim_report(0), KC_A));
+    CHECK_EQ(fast_wake_phase(WAKE_FIRST_KEY), 0);
+    CHECK_EQ(fast_wake_phase(WAKE_FIRST_REPORT), 0);
+    test_key("A", false);
+
+    // Frame built at FAST_WAKE_RGB_DELAY, RGB task started one scan later
+    sim_run_ms(FAST_WAKE_RGB_DELAY + 1);
+    CHECK(rgb_matrix_is_enabled());
+    CHECK_EQ(fast_wake_phase(WAKE_RGB_READY), FAST_WAKE_RGB_DELAY + 1);
+
+    // The first lit frame is the indicator frame, not the startup effect
+    sim_run_ms(40);
+    const sim_frame_t *frame = sim_frame(sim_frame_count() - 1);
+    CHECK(frame->leds[40].r > 0);
+    CHECK(frame->leds[40].r < RGB_MATRIX_STARTUP_VAL);
+}
+
+static void test_keys_first(void) {
+    sim_reset();
+    sim_run_ms(FAST_WAKE_RGB_DELAY - 2);
+    // A key event in every scan: the RGB steps wait for a quiet one
+    for (int i = 0; i < 10; i++) {
+        test_key("A", i % 2 == 0);
+        sim_run_ms(1);
+    }
+    CHECK(!rgb_matrix_is_enabled());
+    CHECK_EQ(fast_wake_phase(WAKE_RGB_READY), WAKE_NOT_REACHED);
+    sim_run_ms(2);
+    CHECK(rgb_matrix_is_enabled());
+}
+
+// Asleep with Bluetooth disconnected, woken by a keystroke
+static void sleep_and_wake(void) {
+    sim_reset();
+    sim_run_ms(100);
+    suspend_power_down_user();
+    sim_set_transport_ready(false);
+    suspend_wakeup_init_user();
+}
+
+static void test_wake_replay(void) {
+    sleep_and_wake();
+    size_t from = sim_report_count();
+    test_tap("A", 20);
+    test_tap("CAPS", 30);  // Esc, resolved by tap/hold arbitration
+    CHECK_EQ(sim_report_count(), from);  // the transport dropped them
+    CHECK_EQ(fast_wake_held(), 4);
+
+    sim_run_ms(200);
+    sim_set_transport_ready(true);
+    uint64_t ready_at = sim_now_us();
+    sim_run_ms(1);
+    CHECK_EQ(sim_report_count() - from, 4);
+    CHECK(nkro_has(sim_report(from), KC_A));
+    CHECK(!nkro_has(sim_report(from + 1), KC_A));
+    CHECK(nkro_has(sim_report(from + 2), KC_ESC));
+    CHECK(!nkro_has(sim_report(from + 3), KC_ESC));
+    CHECK_EQ(sim_report(from)->time_us, ready_at);
+    CHECK_EQ(fast_wake_held(), 0);
+
+    CHECK_EQ(fast_wake_phase(WAKE_FIRST_KEY), 0);
+    CHECK_EQ(fast_wake_phase(WAKE_TRANSPORT_READY), ready_at / 1000 - 100);
+    CHECK_EQ(fast_wake_phase(WAKE_FIRST_REPORT), fast_wake_phase(WAKE_TRANSPORT_READY));
+
+    // Connected: no more holding
+    from = sim_report_count();
+    test_tap("B", 20);
+    CHECK_EQ(sim_report_count() - from, 2);
+    CHECK_EQ(fast_wake_held(), 0);
+}
+
+static void test_stale(void) {
+    sleep_and_wake();
+    size_t from = sim_report_count();
+    test_tap("A", 20);
+    sim_run_ms(FAST_WAKE_BUFFER_TIMEOUT);
+    sim_set_transport_ready(true);
+    sim_run_ms(1);
+    CHECK_EQ(sim_report_count(), from);
+}
+
+static void test_overflow(void) {
+    sleep_and_wake();
+    size_t from = sim_report_count();
+    for (int i = 0; i < FAST_WAKE_BUFFER_SIZE; i++) {
+        test_tap("A", 20);
+    }
+    CHECK_EQ(fast_wake_held(), FAST_WAKE_BUFFER_SIZE);
+    sim_set_transport_ready(true);
+    sim_run_ms(1);
+    // The host ends up with every key released
+    CHECK_EQ(sim_report_count() - from, FAST_WAKE_BUFFER_SIZE);
+    CHECK(!nkro_has(sim_report(sim_report_count() - 1), KC_A));
+}
+
+int main(void) {
+    test_boot();
+    test_keys_first();
+    test_wake_replay();
+    test_stale();
+    test_overflow();
+    TEST_DONE();
+}
@@ -0,0 +1,234 @@
+// Footprint report: symbols and sizes out of a GNU ld map, stack depth over the
+// objdump call graph, and the diff between two snapshots.
+
+#include <string.h>
+
+#include "test.h"
+#include "footprint.h"
+
+static FILE *text(const char *s) {
+    FILE *f = fmemopen((void *)s, strlen(s), "r");
+    if (!f) {
+        perror("fmemopen");
+        exit(2);
+    }
+    return f;
+}
+
+// Trimmed from a real keychron_v4_max_ansi map
+static const char MAP[] =
+    "Archive member included to satisfy reference by file (symbol)\n"
+    "\n"
+    "Discarded input sections\n"
+    "\n"
+    " .text.unused    0x0000000000000000       0x40 .build/obj_x/keyboards/keychron/common/unused.o\n"
+    "\n"
+    "Memory Configuration\n"
+    "\n"
+    "Name             Origin             Length             Attributes\n"
+    "flash0           0x0000000008000000 0x0000000000040000 xr\n"
+    "\n"
+    "Linker script and memory map\n"
+    "\n"
+    "LOAD .build/obj_x/keymap.o\n"
+    "\n"
+    ".vectors        0x0000000008000000      0x198\n"
+    " *(.vectors)\n"
+    " .vectors       0x0000000008000000      0x198 lib/chibios/os/common/startup/vectors.o\n"
+    "\n"
+    ".text           0x0000000008000200     0x1000\n"
+    " *(.text .text.*)\n"
+    " .text.process_record_user\n"
+    "                0x0000000008000200      0x2a4 .build/obj_x/keyboards/keychron/v4_max/keymaps/custom/keymap.o\n"
+    "                0x0000000008000200                process_record_user\n"
+    " .text          0x00000000080004a4       0x5c /usr/lib/arm-none-eabi/newlib/thumb/v7e-m/libc_nano.a(lib_a-memcpy.o)\n"
+    "                0x00000000080004a4                memcpy\n"
+    " .text.rgb_frame_rebuild\n"
+    "                0x0000000008000500      0x180 .build/obj_x/keyboards/keychron/v4_max/keymaps/custom/keymap.o\n"
+    " *fill*         0x0000000008000680        0x8 \n"
+    "\n"
+    ".data           0x0000000020000800       0x10 load address 0x0000000008001200\n"
+    " .data.user_config\n"
+    "                0x0000000020000800       0x10 .build/obj_x/keyboards/keychron/v4_max/keymaps/custom/user_config.o\n"
+    "\n"
+    ".bss            0x0000000020000810      0x120\n"
+    " .bss.frame     0x0000000020000810       0x60 .build/obj_x/keyboards/keychron/v4_max/keymaps/custom/keymap.o\n"
+    " COMMON         0x0000000020000870       0xc0 .build/obj_x/quantum/rgb_matrix/rgb_matrix.o\n"
+    "                0x0000000020000870                rgb_matrix_config\n"
+    "\n"
+    ".heap           0x0000000020000930     0xf6d0\n"
+    "\n"
+    ".debug_info     0x0000000000000000    0x12345\n"
+    " .debug_info    0x0000000000000000     0x1000 .build/obj_x/keyboards/keychron/v4_max/keymaps/custom/keymap.o\n";
+
+static const fp_symbol_t *symbol(const fp_map_t *map, const char *name) {
+    for (size_t i = 0; i < map->count; i++) {
+        if (strcmp(map->symbols[i].name, name) == 0) return &map->symbols[i];
+    }
+    return NULL;
+}
+
+static void test_map(void) {
+    fp_map_t map;
+    FILE    *f = text(MAP);
+    CHECK(fp_parse_map(f, &map));
+    fclose(f);
+
+    // Output sections: .vectors + .text + .data's load image; .data + .bss in RAM
+    CHECK_EQ(map.flash, 0x198 + 0x1000 + 0x10);
+    CHECK_EQ(map.ram, 0x10 + 0x120);
+    CHECK_EQ(map.heap, 0xf6d0);
+
+    CHECK(symbol(&map, "unused") == NULL);  // discarded
+    const fp_symbol_t *sym = symbol(&map, "process_record_user");
+    CHECK(sym != NULL);
+    if (sym) {
+        CHECK_EQ(sym->flash, 0x2a4);
+        CHECK_EQ(sym->ram, 0);
+        CHECK(strcmp(sym->object, "keymap.o") == 0);
+    }
+    sym = symbol(&map, "memcpy");  // plain .text, named by its symbol line
+    CHECK(sym && strcmp(sym->object, "libc_nano.a(lib_a-memcpy.o)") == 0);
+    sym = symbol(&map, "user_config");
+    CHECK(sym && sym->flash == 0x10 && sym->ram == 0x10);
+    sym = symbol(&map, "rgb_matrix_config");
+    CHECK(sym && sym->flash == 0 && sym->ram == 0xc0);
+    CHECK(symbol(&map, "debug_info") == NULL);
+
+    fp_map_sort(&map);
+    CHECK(strcmp(map.symbols[0].name, "process_record_user") == 0);
+
+    fp_map_t objects;
+    fp_map_by_object(&map, &objects);
+    CHECK(strcmp(objects.symbols[0].name, "keymap.o") == 0);
+    CHECK_EQ(objects.symbols[0].flash, 0x2a4 + 0x180);
+    CHECK_EQ(objects.symbols[0].ram, 0x60);
+    fp_map_free(&objects);
+    fp_map_free(&map);
+
+    CHECK(!fp_parse_map(f = text("not a map\n"), &map));
+    fclose(f);
+}
+
+static const char STACK_USAGE[] =
+    "keymap.c:120:6:process_record_user\t24\tstatic\n"
+    "keymap.c:300:13:rgb_frame_rebuild\t48\tstatic\n"
+    "overrides.c:40:13:apply\t16\tstatic\n"
+    "user_config.c:40:13:apply\t32\tstatic\n"  // static functions can share a name
+    "rgb_matrix.c:80:6:rgb_matrix_indicators_advanced_user\t8\tstatic\n"
+    "keymap.c:500:13:walk\t16\tstatic\n"
+    "keymap.c:510:13:scratch\t64\tdynamic,bounded\n";
+
+static const char DISASSEMBLY[] =
+    "\n"
+    "keymap.elf:     file format elf32-littlearm\n"
+    "\n"
+    "Disassembly of section .text:\n"
+    "\n"
+    "08000200 <process_record_user>:\n"
+    " 8000200:\tb510      \tpush\t{r4, lr}\n"
+    " 8000202:\td001      \tbeq.n\t8000208 <process_record_user+0x8>\n"
+    " 8000204:\tf000 f87c \tbl\t8000500 <rgb_frame_rebuild>\n"
+    " 8000208:\tf000 f900 \tbl\t8000600 <apply>\n"
+    " 800020c:\t4798      \tblx\tr3\n"
+    " 800020e:\tf000 b9f7 \tb.w\t80004a4 <memcpy>\n"
+    "\n"
+    "080004a4 <memcpy>:\n"
+    " 80004a4:\t4770      \tbx\tlr\n"
+    "\n"
+    "08000500 <rgb_frame_rebuild>:\n"
+    " 8000500:\tb500      \tpush\t{lr}\n"
+    " 8000502:\tf000 f800 \tbl\t8000600 <apply>\n"
+    " 8000506:\te7fb      \tb.n\t8000500 <rgb_frame_rebuild>\n"
+    "\n"
+    "08000600 <apply>:\n"
+    " 8000600:\t4770      \tbx\tlr\n"
+    "\n"
+    "08000700 <rgb_matrix_indicators_advanced_user>:\n"
+    " 8000700:\tf000 f810 \tbl\t8000720 <walk>\n"
+    "\n"
+    "08000720 <walk>:\n"
+    " 8000720:\tf000 f808 \tbl\t8000740 <scratch>\n"
+    "\n"
+    "08000740 <scratch>:\n"
+    " 8000740:\tf7ff ffee \tbl\t8000720 <walk>\n";
+
+static void test_stack(void) {
+    fp_graph_t graph = {0};
+    FILE      *f     = text(STACK_USAGE);
+    CHECK(fp_parse_stack_usage(f, &graph));
+    fclose(f);
+    CHECK(fp_parse_disassembly(f = text(DISASSEMBLY), &graph));
+    fclose(f);
+
+    // process_record_user 24 > rgb_frame_rebuild 48 > apply 32 (the larger of the two);
+    // memcpy has no .su and the blx through r3 cannot be followed
+    fp_stack_t stack;
+    fp_stack_depth(&graph, "process_record_user", &stack);
+    CHECK_EQ(stack.bytes, 24 + 48 + 32);
+    CHECK(strcmp(stack.path, "process_record_user > rgb_frame_rebuild > apply") == 0);
+    CHECK(stack.flags & FP_STACK_INDIRECT);
+    CHECK(stack.flags & FP_STACK_UNKNOWN);
+    CHECK(!(stack.flags & FP_STACK_RECURSIVE));
+
+    // walk <-> scratch recurse: one trip round the cycle is counted, and flagged
+    fp_stack_depth(&graph, "rgb_matrix_indicators_advanced_user", &stack);
+    CHECK_EQ(stack.bytes, 8 + 16 + 64);
+    CHECK(stack.flags & FP_STACK_RECURSIVE);
+    CHECK(stack.flags & FP_STACK_DYNAMIC);
+    CHECK(!(stack.flags & FP_STACK_INDIRECT));
+
+    fp_stack_depth(&graph, "matrix_scan_user", &stack);
+    CHECK(stack.flags & FP_STACK_NOT_FOUND);
+    fp_graph_free(&graph);
+}
+
+static void test_snapshot(void) {
+    fp_snapshot_t before = {0}, after = {0}, read = {0};
+    fp_snapshot_add(&before, "total", "flash", 1000);
+    fp_snapshot_add(&before, "flash", "keymap.o:process_record_user", 600);
+    fp_snapshot_add(&before, "flash", "keymap.o:old", 40);
+    fp_snapshot_add(&before, "stack", "process_record_user", 96);
+
+    fp_snapshot_add(&after, "total", "flash", 1100);
+    fp_snapshot_add(&after, "flash", "keymap.o:process_record_user", 620);
+    fp_snapshot_add(&after, "flash", "fast_wake.o:fast_wake_task", 120);
+    fp_snapshot_add(&after, "stack", "process_record_user", 96);
+
+    // Round trip through the file format
+    char   buffer[1024];
+    FILE  *f = fmemopen(buffer, sizeof(buffer), "w");
+    fp_snapshot_write(f, &after);
+    fclose(f);
+    CHECK(fp_snapshot_read(f = text(buffer), &read));
+    fclose(f);
+    CHECK_EQ(read.count, after.count);
+    CHECK(strcmp(read.entries[2].name, "fast_wake.o:fast_wake_task") == 0);
+    CHECK_EQ(read.entries[2].value, 120);
+
+    char out[2048] = "";
+    f              = fmemopen(out, sizeof(out), "w");
+    fp_snapshot_diff(f, &before, &read, 2);
+    fclose(f);
+    // Totals and stack first, even unchanged; then by size of the change
+    const char *total = strstr(out, "total");
+    const char *stack = strstr(out, "stack");
+    const char *added = strstr(out, "fast_wake.o:fast_wake_task");
+    const char *gone  = strstr(out, "keymap.o:old");
+    CHECK(total && stack && added && gone);
+    CHECK(total < stack && stack < added && added < gone);
+    CHECK(strstr(out, "+100") != NULL);
+    CHECK(strstr(out, "(new)") && strstr(out, "(gone)"));
+    CHECK(strstr(out, "... 1 more") != NULL);  // process_record_user's +20
+
+    fp_snapshot_free(&before);
+    fp_snapshot_free(&after);
+    fp_snapshot_free(&read);
+}
+
+int main(void) {
+    test_map();
+    test_stack();
+    test_snapshot();
+    TEST_DONE();
+}
@@ -0,0 +1,193 @@
+// Latency trace: the ring keeps the newest entries, the raw HID protocol reads
+// them out, and the decoder pairs stages into the right spans.
+
+#include "test.h"
+#include "latency_decode.h"
+#include "latency_trace.h"
+
+// Reads the whole trace over raw HID, the way latency_decode -d does.
+static size_t capture(uint8_t *out, size_t room) {
+    uint8_t packet[RAW_EPSIZE] = {LATENCY_TRACE_RAW_HID_ID, LT_CMD_INFO};
+    size_t  length             = 0;
+    CHECK(sim_raw_hid(packet));
+    memcpy(out, packet, RAW_EPSIZE);
+    length += RAW_EPSIZE;
+
+    uint32_t written = latency_trace_written();
+    uint32_t seq     = written > LATENCY_TRACE_SIZE ? written - LATENCY_TRACE_SIZE : 0;
+    while (seq < written && length + RAW_EPSIZE <= room) {
+        memset(packet, 0, sizeof(packet));
+        packet[0] = LATENCY_TRACE_RAW_HID_ID;
+        packet[1] = LT_CMD_READ;
+        packet[2] = seq & 0xFF;
+        packet[3] = (seq >> 8) & 0xFF;
+        packet[4] = (seq >> 16) & 0xFF;
+        packet[5] = seq >> 24;
+        CHECK(sim_raw_hid(packet));
+        if (packet[6] == 0) break;
+        memcpy(out + length, packet, RAW_EPSIZE);
+        length += RAW_EPSIZE;
+        seq = (uint32_t)(packet[2] | packet[3] << 8 | packet[4] << 16 | (uint32_t)packet[5] << 24) + packet[6];
+    }
+    return length;
+}
+
+static void clear(void) {
+    uint8_t packet[RAW_EPSIZE] = {LATENCY_TRACE_RAW_HID_ID, LT_CMD_CLEAR};
+    CHECK(sim_raw_hid(packet));
+    CHECK_EQ(latency_trace_written(), 0);
+}
+
+static void test_ring(void) {
+    sim_reset();
+    clear();
+    for (uint32_t i = 0; i < LATENCY_TRACE_SIZE + 10; i++) {
+        latency_trace_record(LT_MATRIX, (uint8_t)i);
+    }
+
+    latency_entry_t entry;
+    // The oldest slot is the one the next record overwrites: not readable
+    CHECK(!latency_trace_read(10, &entry));
+    CHECK(latency_trace_read(11, &entry));
+    CHECK_EQ(entry.key, 11);
+    CHECK(!latency_trace_read(LATENCY_TRACE_SIZE + 10, &entry));
+
+    // A READ behind the ring is moved up to the oldest entry still there
+    uint8_t packet[RAW_EPSIZE] = {LATENCY_TRACE_RAW_HID_ID, LT_CMD_READ};
+    CHECK(sim_raw_hid(packet));
+    CHECK_EQ(packet[2], 11);
+    CHECK_EQ(packet[6], LATENCY_TRACE_ENTRIES_PER_PACKET);
+    CHECK_EQ(packet[7 + 4], LT_MATRIX);
+    CHECK_EQ(packet[7 + 5], 11);
+
+    static uint8_t  buf[RAW_EPSIZE * (2 + LATENCY_TRACE_SIZE / LATENCY_TRACE_ENTRIES_PER_PACKET)];
+    latency_dump_t dump;
+    CHECK_EQ(latency_dump_parse(buf, capture(buf, sizeof(buf)), &dump), 0);
+    CHECK_EQ(dump.count, LATENCY_TRACE_SIZE - 1);
+    CHECK_EQ(dump.lost, 11);
+    CHECK_EQ(dump.first_seq, 11);
+    CHECK_EQ(dump.entries[LATENCY_TRACE_SIZE - 2].key, (uint8_t)(LATENCY_TRACE_SIZE + 9));
+    latency_dump_free(&dump);
+
+    // Packets that are not ours are left for someone else
+    uint8_t other[RAW_EPSIZE] = {0x01};
+    CHECK(!sim_raw_hid(other));
+}
+
+// ---------------------------------------------------------------------------
+// Synthetic dump: 100 keystrokes, the i-th taking i us from matrix to report
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+static void test_synthetic(void) {
+    latency_entry_t entries[700];
+    size_t          n = 0;
+    uint32_t        t = 0xFFFFF000;  // wraps mid-dump
+    for (uint32_t i = 1; i <= 100; i++) {
+        uint8_t key  = LT_KEY(i % 5, i % 14);
+        entries[n++] = (latency_entry_t){t, LT_MATRIX, key};
+        entries[n++] = (latency_entry_t){t + i / 2, LT_PRU_ENTER, key};
+        entries[n++] = (latency_entry_t){t + i / 2, LT_PRU_EXIT, key};
+        entries[n++] = (latency_entry_t){t + i, LT_REPORT, key};
+        entries[n++] = (latency_entry_t){t + i + 5, LT_SENT, LT_KEY_NONE};
+        // Unrelated report: no keystroke is waiting for one
+        entries[n++] = (latency_entry_t){t + 1000, LT_REPORT, key};
+        entries[n++] = (latency_entry_t){t + 1001, LT_SENT, LT_KEY_NONE};
+        t += 2000;
+    }
+
+    static uint8_t buf[RAW_EPSIZE * 256];
+    size_t         length = 0;
+    uint8_t       *p      = buf;
+    p[0] = LATENCY_TRACE_RAW_HID_ID;
+    p[1] = LT_CMD_INFO;
+    p[2] = LATENCY_TRACE_VERSION;
+    p[3] = LATENCY_TRACE_ENTRY_SIZE;
+    p[4] = 0x00;
+    p[5] = 0x04;  // capacity 1024
+    put_u32(p + 6, (uint32_t)n);
+    put_u32(p + 10, 1000000);
+    length += RAW_EPSIZE;
+    for (size_t i = 0; i < n; i += LATENCY_TRACE_ENTRIES_PER_PACKET) {
+        p    = buf + length;
+        p[0] = LATENCY_TRACE_RAW_HID_ID;
+        p[1] = LT_CMD_READ;
+        put_u32(p + 2, (uint32_t)i);
+        p[6] = (uint8_t)MIN(n - i, (size_t)LATENCY_TRACE_ENTRIES_PER_PACKET);
+        for (uint8_t j = 0; j < p[6]; j++) {
+            uint8_t *e = p + 7 + j * LATENCY_TRACE_ENTRY_SIZE;
+            put_u32(e, entries[i + j].time);
+            e[4] = entries[i + j].stage;
+            e[5] = entries[i + j].key;
+        }
+        length += RAW_EPSIZE;
+    }
+
+    latency_dump_t  dump;
+    latency_stats_t stats[LT_SPAN_COUNT];
+    CHECK_EQ(latency_dump_parse(buf, length, &dump), 0);
+    CHECK_EQ(dump.count, n);
+    CHECK_EQ(dump.lost, 0);
+    latency_analyze(&dump, stats);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_REPORT].count, 100);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_REPORT].p50_us, 50);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_REPORT].p99_us, 99);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_REPORT].max_us, 100);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_PRU].max_us, 50);
+    CHECK_EQ(stats[LT_SPAN_PRU].max_us, 0);
+    CHECK_EQ(stats[LT_SPAN_TAP_HOLD].count, 0);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_SENT].count, 100);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_SENT].p50_us, 55);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_SENT].max_us, 105);
+    CHECK_EQ(stats[LT_SPAN_REPORT_TO_SENT].count, 200);
+    CHECK_EQ(stats[LT_SPAN_REPORT_TO_SENT].p50_us, 1);
+    CHECK_EQ(stats[LT_SPAN_REPORT_TO_SENT].p99_us, 5);
+    // 1 us lands in the [1, 2) bucket, 100 us in [64, 128)
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_REPORT].histogram[1], 1);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_REPORT].histogram[7], 37);
+    latency_dump_free(&dump);
+
+    // Truncated and foreign captures are rejected
+    CHECK_EQ(latency_dump_parse(buf, length - 1, &dump), -1);
+    buf[RAW_EPSIZE] = 0x01;
+    CHECK_EQ(latency_dump_parse(buf, length, &dump), -1);
+}
+
+// ---------------------------------------------------------------------------
+// The keymap stamps every stage; the tap/hold hold-off shows up end to end
+
+static void test_keymap(void) {
+    sim_reset();
+    sim_run_ms(10);
+    clear();
+
+    test_tap("A", 30);
+    test_tap("CAPS", 40);  // Esc, decided on release
+
+    static uint8_t  buf[RAW_EPSIZE * (2 + LATENCY_TRACE_SIZE / LATENCY_TRACE_ENTRIES_PER_PACKET)];
+    latency_dump_t  dump;
+    latency_stats_t stats[LT_SPAN_COUNT];
+    CHECK_EQ(latency_dump_parse(buf, capture(buf, sizeof(buf)), &dump), 0);
+    CHECK_EQ(dump.clock_hz, 1000000);
+    latency_analyze(&dump, stats);
+
+    // A down/up and Esc down/up; a plain key goes out in its own scan
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_REPORT].count, 4);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_REPORT].p50_us, 0);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_REPORT].max_us, 40000);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_SENT].count, 4);
+    CHECK_EQ(stats[LT_SPAN_MATRIX_TO_SENT].max_us, 40000);
+    CHECK_EQ(stats[LT_SPAN_TAP_HOLD].count, 1);
+    CHECK_EQ(stats[LT_SPAN_TAP_HOLD].max_us, 40000);
+    CHECK_EQ(stats[LT_SPAN_PRU].count, 4);
+    latency_dump_free(&dump);
+}
+
+int main(void) {
+    test_ring();
+    test_synthetic();
+    test_keymap();
+    TEST_DONE();
+}
@@ -0,0 +1,132 @@
+// Key overrides: the replacement goes out in the same report as the modifier
+// change, on press and on release, and nothing is left stuck.
+
+#include "test.h"
+
+static bool nkro_has(const sim_report_t *r, uint8_t code) {
+    return r->kind == SIM_REPORT_NKRO && (r->nkro.bits[code >> 3] & (1 << (code & 7)));
+}
+
+static bool nkro_empty(const sim_report_t *r) {
+    for (int i = 0; i < NKRO_REPORT_BITS; i++) {
+        if (r->nkro.bits[i]) return false;
+    }
+    return true;
+}
+
+static void enter_numpad(void) {
+    test_key("RCTL", true);
+    sim_run_ms(10);
+    test_tap("R", 20);
+    test_key("RCTL", false);
+    sim_run_ms(20);
+}
+
+static void test_shift_dot(void) {
+    sim_reset();
+    enter_numpad();
+
+    test_key("LSFT", true);
+    sim_run_ms(10);
+    size_t from = sim_report_count();
+    test_key("SLSH", true);  // KC_DOT in the numpad layer
+    sim_run_ms(300);
+    // One report: / down with Shift lifted (was four reports with tap_code)
+    CHECK_EQ(sim_report_count() - from, 1);
+    CHECK(nkro_has(sim_report(from), KC_SLSH));
+    CHECK_EQ(sim_report(from)->nkro.mods, 0);
+
+    test_key("SLSH", false);
+    sim_run_ms(10);
+    // One report: / up and Shift back
+    CHECK_EQ(sim_report_count() - from, 2);
+    CHECK(nkro_empty(sim_report(from + 1)));
+    CHECK_EQ(sim_report(from + 1)->nkro.mods, MOD_BIT(KC_LSFT));
+
+    test_key("LSFT", false);
+    sim_run_ms(10);
+    CHECK_EQ(sim_report(sim_report_count() - 1)->nkro.mods, 0);
+
+    // Without Shift it is still a plain numpad "."
+    from = sim_report_count();
+    test_tap("SLSH", 20);
+    CHECK_EQ(sim_report_count() - from, 2);
+    CHECK(nkro_has(sim_report(from), KC_DOT));
+}
+
+static void test_shift_released_first(void) {
+    sim_reset();
+    enter_numpad();
+
+    test_key("RSFT", true);
+    sim_run_ms(10);
+    test_key("SLSH", true);
+    sim_run_ms(10);
+    size_t from = sim_report_count();
+    test_key("RSFT", false);
+    sim_run_ms(10);
+    CHECK_EQ(sim_report_count(), from);  // Shift was already out of the report
+    test_key("SLSH", false);
+    sim_run_ms(10);
+    // Shift must not come back after it was physically released
+    CHECK_EQ(sim_report_count() - from, 1);
+    CHECK_EQ(sim_report(from)->nkro.mods, 0);
+    CHECK(nkro_empty(sim_report(from)));
+}
+
+static void test_numpad_backslash(void) {
+    sim_reset();
+    enter_numpad();
+
+    size_t from = sim_report_count();
+    test_key("BSLS", true);
+    sim_run_ms(20);
+    CHECK_EQ(sim_report_count() - from, 1);
+    CHECK(nkro_has(sim_report(from), KC_SLSH));
+
+    // Ctrl pressed in between: the release still ends the override
+    test_key("RCTL", true);
+    sim_run_ms(10);
+    test_key("BSLS", false);
+    sim_run_ms(10);
+    test_key("RCTL", false);
+    sim_run_ms(10);
+    CHECK_EQ(sim_report_count() - from, 2);
+    CHECK(nkro_empty(sim_report(from + 1)));
+}
+
+static void test_ctrl_slash(void) {
+    sim_reset();
+
+    test_key("RCTL", true);
+    sim_run_ms(10);
+    size_t from = sim_report_count();
+    test_key("SLSH", true);
+    sim_run_ms(20);
+    // Up stays down while / is held, so it auto-repeats on the host
+    CHECK_EQ(sim_report_count() - from, 1);
+    CHECK(nkro_has(sim_report(from), KC_UP));
+    CHECK_EQ(sim_report(from)->nkro.mods, 0);
+
+    // Ctrl released first: Up still ends with the / key
+    test_key("RCTL", false);
+    sim_run_ms(10);
+    CHECK_EQ(sim_report_count() - from, 1);
+    test_key("SLSH", false);
+    sim_run_ms(10);
+    CHECK_EQ(sim_report_count() - from, 2);
+    CHECK(nkro_empty(sim_report(from + 1)));
+
+    // Without Ctrl it is a plain /
+    from = sim_report_count();
+    test_tap("SLSH", 20);
+    CHECK(nkro_has(sim_report(from), KC_SLSH));
+}
+
+int main(void) {
+    test_shift_dot();
+    test_shift_released_first();
+    test_numpad_backslash();
+    test_ctrl_slash();
+    TEST_DONE();
+}
@@ -0,0 +1,155 @@
+// Report queue: reports within a scan merge only when no key or modifier edge
+// would be lost, no-ops are dropped, and the counters add up.
+
+#include "test.h"
+#include "report_queue.h"
+
+static report_nkro_t  sent[16];
+static report_extra_t sent_extra[16];
+static unsigned       sent_count, sent_extra_count;
+
+static void out_send_nkro(report_nkro_t *report) {
+    if (sent_count < ARRAY_SIZE(sent)) sent[sent_count] = *report;
+    sent_count++;
+}
+
+static void out_send_extra(report_extra_t *report) {
+    if (sent_extra_count < ARRAY_SIZE(sent_extra)) sent_extra[sent_extra_count] = *report;
+    sent_extra_count++;
+    sent_count++;
+}
+
+static host_driver_t out = {
+    .send_nkro  = out_send_nkro,
+    .send_extra = out_send_extra,
+};
+
+static report_nkro_t nkro(uint8_t mods, uint8_t code) {
+    report_nkro_t report = {.report_id = 6, .mods = mods};
+    if (code) report.bits[code >> 3] |= 1 << (code & 7);
+    return report;
+}
+
+static void queue_nkro(uint8_t mods, uint8_t code) {
+    report_nkro_t report = nkro(mods, code);
+    report_queue_nkro(&report, &out);
+}
+
+static void start(void) {
+    report_queue_reset();
+    sent_count = sent_extra_count = 0;
+}
+
+static void test_merge(void) {
+    start();
+    // Ctrl down, then A down with Ctrl: one report carrying both
+    queue_nkro(MOD_BIT(KC_LCTL), KC_NO);
+    queue_nkro(MOD_BIT(KC_LCTL), KC_A);
+    CHECK_EQ(sent_count, 0);
+    report_queue_flush(&out);
+    CHECK_EQ(sent_count, 1);
+    report_nkro_t expected = nkro(MOD_BIT(KC_LCTL), KC_A);
+    CHECK(memcmp(&sent[0], &expected, sizeof(expected)) == 0);
+    CHECK_EQ(report_queue_stats()->generated, 2);
+    CHECK_EQ(report_queue_stats()->merged, 1);
+    CHECK_EQ(report_queue_stats()->sent, 1);
+}
+
+static void test_tap_is_kept(void) {
+    start();
+    // A down and up within one scan: the host must still see the press
+    queue_nkro(0, KC_A);
+    queue_nkro(0, KC_NO);
+    report_queue_flush(&out);
+    CHECK_EQ(sent_count, 2);
+    CHECK_EQ(report_queue_stats()->merged, 0);
+
+    // Shift lifted for one report and put back (a mods flicker) is kept too
+    start();
+    queue_nkro(MOD_BIT(KC_LSFT), KC_NO);
+    report_queue_flush(&out);
+    queue_nkro(0, KC_SLSH);
+    queue_nkro(MOD_BIT(KC_LSFT), KC_NO);
+    report_queue_flush(&out);
+    CHECK_EQ(sent_count, 3);
+}
+
+static void test_drop(void) {
+    start();
+    queue_nkro(0, KC_A);
+    report_queue_flush(&out);
+    // Same as what the host has: nothing to send
+    queue_nkro(0, KC_A);
+    report_queue_flush(&out);
+    CHECK_EQ(sent_count, 1);
+    CHECK_EQ(report_queue_stats()->dropped, 1);
+
+    // Consumer usages are never merged, only deduplicated
+    report_extra_t mute = {.report_id = REPORT_ID_CONSUMER, .usage = 0x00E2}, none = {.report_id = REPORT_ID_CONSUMER};
+    report_queue_extra(&mute, &out);
+    report_queue_extra(&mute, &out);
+    report_queue_extra(&none, &out);
+    report_queue_flush(&out);
+    CHECK_EQ(sent_count, 3);
+    CHECK_EQ(report_queue_stats()->dropped, 2);
+
+    // System control keeps its own state: with Sleep and Mute overlapping, each
+    // release matches the other report id's last usage and must still go out
+    report_extra_t  sleep = {.report_id = REPORT_ID_SYSTEM, .usage = 0x0082}, awake = {.report_id = REPORT_ID_SYSTEM};
+    report_extra_t *order[] = {&sleep, &mute, &awake, &none};
+    sent_extra_count        = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(order); i++) {
+        report_queue_extra(order[i], &out);
+        report_queue_flush(&out);
+    }
+    CHECK_EQ(sent_extra_count, 4);
+    CHECK_EQ(sent_extra[3].report_id, REPORT_ID_CONSUMER);
+    CHECK_EQ(sent_extra[3].usage, 0);
+    CHECK_EQ(report_queue_stats()->dropped, 2);
+}
+
+static void test_overflow(void) {
+    start();
+    // Alternating down/up never merges; the oldest goes out when the queue is full
+    for (int i = 0; i < REPORT_QUEUE_SIZE + 2; i++) {
+        queue_nkro(0, i % 2 ? KC_NO : KC_B);
+    }
+    CHECK_EQ(sent_count, 2);
+    report_queue_flush(&out);
+    CHECK_EQ(sent_count, REPORT_QUEUE_SIZE + 2);
+    const report_queue_stats_t *stats = report_queue_stats();
+    CHECK_EQ(stats->generated, stats->sent + stats->merged + stats->dropped);
+}
+
+// Through the keymap: Ctrl (Caps held) + A goes out as one report
+static void test_keymap(void) {
+    sim_reset();
+    sim_run_ms(10);
+
+    size_t from = sim_report_count();
+    test_key("CAPS", true);
+    sim_run_ms(10);
+    test_key("A", true);
+    sim_run_ms(10);
+    CHECK_EQ(sim_report_count() - from, 1);
+    CHECK(test_find_report(from, KC_A, MOD_BIT(KC_LCTL)) == (long)from);
+    test_key("A", false);
+    test_key("CAPS", false);
+    sim_run_ms(10);
+
+    // ...and both releases in one scan also share a report
+    const report_queue_stats_t *stats = report_queue_stats();
+    CHECK_EQ(sim_report_count() - from, 2);
+    CHECK_EQ(stats->sent, 2);
+    CHECK_EQ(stats->merged, 2);
+    CHECK_EQ(stats->generated, stats->sent + stats->merged + stats->dropped);
+}
+
+int main(void) {
+    test_merge();
+    test_tap_is_kept();
+    test_drop();
+    test_overflow();
+    test_keymap();
+    TEST_DONE();
+}
@@ -0,0 +1,150 @@
+// RGB power management: gamma steps, the current cap, idle dimming down to a
+// stopped RGB task, indicators that stay lit, and the battery settings.
+
+#include "test.h"
+#include "rgb_power.h"
+
+static bool on_battery;
+
+bool rgb_power_on_battery(void) {
+    return on_battery;
+}
+
+static const rgb_t *last_frame(void) {
+    return sim_frame(MIN(sim_frame_count(), (size_t)SIM_LOG_MAX) - 1)->leds;
+}
+
+static void test_gamma_and_scale(void) {
+    CHECK_EQ(rgb_power_gamma(0), 0);
+    CHECK_EQ(rgb_power_gamma(255), 255);
+    CHECK_EQ(rgb_power_gamma(155), 95);
+    for (int v = 1; v < 256; v++) {
+        CHECK(rgb_power_gamma(v) >= rgb_power_gamma(v - 1));
+    }
+    CHECK_EQ(rgb_power_scale(200, 255), 200);
+    CHECK_EQ(rgb_power_scale(200, 0), 0);
+    CHECK_EQ(rgb_power_scale(255, 64), 64);
+}
+
+static uint32_t frame_ma(uint8_t frame[][3], uint8_t count) {
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        sum += frame[i][0] + frame[i][1] + frame[i][2];
+    }
+    return sum * RGB_POWER_CHANNEL_MA / 255;
+}
+
+static void test_budget(void) {
+    static uint8_t frame[RGB_MATRIX_LED_COUNT][3];
+    rgb_power_reset();
+
+    // Full white is over the USB budget: scaled down to it, evenly
+    memset(frame, 255, sizeof(frame));
+    rgb_power_finish_frame(frame, RGB_MATRIX_LED_COUNT);
+    CHECK(frame_ma(frame, RGB_MATRIX_LED_COUNT) <= RGB_POWER_BUDGET_MA);
+    CHECK(frame_ma(frame, RGB_MATRIX_LED_COUNT) >= RGB_POWER_BUDGET_MA * 9 / 10);
+    CHECK_EQ(frame[0][0], frame[RGB_MATRIX_LED_COUNT - 1][2]);
+
+    // A few indicators are left alone
+    memset(frame, 0, sizeof(frame));
+    frame[3][1] = 255;
+    rgb_power_finish_frame(frame, RGB_MATRIX_LED_COUNT);
+    CHECK_EQ(frame[3][1], 255);
+}
+
+// End to end through keymap.c: dim, then dark and stopped, then back on a key press.
+static void test_idle(void) {
+    on_battery = false;
+    sim_reset();
+
+    sim_run_ms(100);
+    uint8_t full = last_frame()[30].r;
+    CHECK(full > 0);
+    CHECK(rgb_matrix_is_enabled());
+
+    sim_run_ms(RGB_POWER_DIM_TIMEOUT);
+    CHECK_EQ(last_frame()[30].r, RGB_POWER_DIM_LEVEL);
+    CHECK(rgb_matrix_is_enabled());
+
+    sim_run_ms(RGB_POWER_OFF_TIMEOUT - RGB_POWER_DIM_TIMEOUT);
+    CHECK_EQ(last_frame()[30].r, 0);
+    CHECK(!rgb_matrix_is_enabled());
+
+    test_tap("A", 20);
+    CHECK(rgb_matrix_is_enabled());
+    CHECK_EQ(last_frame()[30].r, full);
+
+    // Turned off by the user (not by us): never switched back on
+    rgb_matrix_disable_noeeprom();
+    test_tap("A", 20);
+    CHECK(!rgb_matrix_is_enabled());
+}
+
+// Layer indicators survive the idle timeout at their floor level
+static void test_indicators(void) {
+    sim_reset();
+
+    test_key("RCTL", true);
+    sim_run_ms(10);
+    test_tap("R", 20);  // numpad layer
+    test_key("RCTL", false);
+    sim_run_ms(50);
+    CHECK_EQ(last_frame()[47].g, 255);
+    CHECK_EQ(last_frame()[40].r, 0);
+
+    sim_run_ms(RGB_POWER_OFF_TIMEOUT);
+    CHECK(rgb_matrix_is_enabled());
+    CHECK_EQ(last_frame()[47].g, rgb_power_scale(255, RGB_POWER_INDICATOR_LEVEL));
+}
+
+static uint64_t next_frame_us(void) {
+    size_t from = sim_frame_count();
+    while (sim_frame_count() == from) {
+        sim_scan();
+    }
+    return sim_frame(from)->time_us;
+}
+
+static uint32_t frame_period_ms(void) {
+    test_key("LCTL", true);
+    uint64_t shown = next_frame_us();
+    test_key("LCTL", false);
+    uint64_t cleared = next_frame_us();
+    sim_run_ms(100);
+    return (uint32_t)((cleared - shown) / 1000);
+}
+
+static void test_battery(void) {
+    on_battery = false;
+    sim_reset();
+    sim_run_ms(100);
+    CHECK_EQ(rgb_power_flush_limit, RGB_POWER_FLUSH_LIMIT);
+
+    on_battery = true;
+    sim_run_ms(100);
+    CHECK_EQ(rgb_power_flush_limit, RGB_POWER_BATTERY_FLUSH_LIMIT);
+    uint8_t frame[RGB_MATRIX_LED_COUNT][3];
+    for (int i = 0; i < RGB_MATRIX_LED_COUNT; i++) {
+        frame[i][0] = last_frame()[i].r;
+        frame[i][1] = last_frame()[i].g;
+        frame[i][2] = last_frame()[i].b;
+    }
+    CHECK(frame_ma(frame, RGB_MATRIX_LED_COUNT) <= RGB_POWER_BATTERY_BUDGET_MA);
+    CHECK(frame[30][0] > 0);
+
+    // Frames go out at the battery rate: Ctrl down shows in one frame, Ctrl up
+    // released right after that can only show a full frame period later
+    CHECK_EQ(frame_period_ms(), RGB_POWER_BATTERY_FLUSH_LIMIT);
+    on_battery = false;
+    sim_run_ms(100);
+    CHECK_EQ(frame_period_ms(), RGB_POWER_FLUSH_LIMIT);
+}
+
+int main(void) {
+    test_gamma_and_scale();
+    test_budget();
+    test_idle();
+    test_indicators();
+    test_battery();
+    TEST_DONE();
+}
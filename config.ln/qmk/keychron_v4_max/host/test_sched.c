@@ -0,0 +1,173 @@
+// Background scheduler: priority order within the per-scan budget, key scans
+// left alone, periods, deadlines and the stats, all on the virtual clock; and
+// the keymap's brightness fade running on it.
+
+#include <string.h>
+
+#include "test.h"
+#include "rgb_power.h"
+#include "sched.h"
+#include "user_config.h"
+
+static char     order[32];
+static uint32_t step_us;  // virtual time each step takes
+static uint8_t  hog_steps;
+
+static uint16_t named(void *arg) {
+    size_t n = strlen(order);
+    if (n + 1 < sizeof(order)) {
+        order[n]     = *(const char *)arg;
+        order[n + 1] = '\0';
+    }
+    sim_advance_us(step_us);
+    return SCHED_DONE;
+}
+
+static uint16_t twice(void *arg) {
+    named(arg);
+    return strlen(order) < 2 ? 3 : SCHED_DONE;
+}
+
+static uint16_t hog(void *arg) {
+    sim_advance_us(SCHED_SCAN_BUDGET_US);
+    return --hog_steps ? 0 : SCHED_DONE;
+}
+
+// Booted, RGB up: sched_task() runs from housekeeping, with only our tasks
+static void boot(void) {
+    sim_reset();
+    sim_run_ms(FAST_WAKE_RGB_DELAY + 10);
+    sched_init();
+    order[0] = '\0';
+    step_us  = 0;
+}
+
+static void test_priority_budget(void) {
+    boot();
+    uint8_t low    = sched_add(named, "L", SCHED_LOW, 0, 5);
+    uint8_t high   = sched_add(named, "H", SCHED_HIGH, 0, 5);
+    uint8_t normal = sched_add(named, "N", SCHED_NORMAL, 0, 5);
+    step_us        = SCHED_SCAN_BUDGET_US * 3 / 5;
+    sched_wake(low, 0);
+    sched_wake(normal, 0);
+    sched_wake(high, 0);
+
+    // Two steps fit (the second runs past the budget), the third waits a scan
+    sim_run_ms(1);
+    CHECK(strcmp(order, "HN") == 0);
+    CHECK_EQ(sched_stats(high)->overruns, 0);
+    CHECK_EQ(sched_stats(normal)->overruns, 1);
+    sim_run_ms(1);
+    CHECK(strcmp(order, "HNL") == 0);
+    CHECK_EQ(sched_stats(low)->latency_max, 1);
+    CHECK_EQ(sched_stats(low)->missed, 0);
+
+    // One-shot: nothing more until woken
+    sim_run_ms(10);
+    CHECK(strcmp(order, "HNL") == 0);
+    CHECK_EQ(sched_stats(high)->jobs, 1);
+    CHECK_EQ(sched_stats(high)->steps, 1);
+    CHECK(sched_add(named, "X", SCHED_LOW, 0, 0) != SCHED_NONE);
+}
+
+static void test_keys_first(void) {
+    boot();
+    uint8_t task = sched_add(named, "T", SCHED_HIGH, 0, 5);
+    test_key("A", true);
+    sched_wake(task, 0);
+    sim_run_ms(1);
+    CHECK(order[0] == '\0');
+    sim_run_ms(1);
+    CHECK(strcmp(order, "T") == 0);
+    test_key("A", false);
+    sim_run_ms(1);
+}
+
+static void test_steps(void) {
+    boot();
+    uint8_t task = sched_add(twice, "T", SCHED_NORMAL, 0, 5);
+    sched_wake(task, 2);
+    sim_run_ms(2);
+    CHECK(order[0] == '\0');
+    sim_run_ms(1);
+    CHECK(strcmp(order, "T") == 0);
+    // Second step 3 ms after the first; one job, not two
+    sim_run_ms(2);
+    CHECK(strcmp(order, "T") == 0);
+    sim_run_ms(1);
+    CHECK(strcmp(order, "TT") == 0);
+    CHECK_EQ(sched_stats(task)->jobs, 1);
+    CHECK_EQ(sched_stats(task)->steps, 2);
+    CHECK_EQ(sched_stats(task)->latency_total, 0);
+}
+
+static void test_period_deadline(void) {
+    boot();
+    uint8_t periodic = sched_add(named, "P", SCHED_LOW, 10, 2);
+    uint8_t busy     = sched_add(hog, NULL, SCHED_HIGH, 0, 0);
+    sim_run_ms(100);
+    CHECK_EQ(sched_stats(periodic)->jobs, 9);  // due at 10, 20, ... 90 ms
+    CHECK_EQ(sched_stats(periodic)->missed, 0);
+
+    // A higher priority job that fills the budget for 5 scans holds it back
+    hog_steps = 5;
+    sched_wake(busy, 0);
+    sim_run_ms(10);
+    CHECK_EQ(sched_stats(periodic)->missed, 1);
+    CHECK(sched_stats(periodic)->latency_max >= 5);
+    CHECK_EQ(sched_stats(busy)->steps, 5);
+    CHECK_EQ(sched_stats(busy)->overruns, 0);
+
+    // Keeps its phase afterwards
+    uint32_t jobs = sched_stats(periodic)->jobs;
+    sim_run_ms(100);
+    CHECK_EQ(sched_stats(periodic)->jobs - jobs, 10);
+}
+
+static void test_load(void) {
+    boot();
+    sim_run_ms(SCHED_LOAD_PERIOD * 2);
+    CHECK(sched_load()->scans >= SCHED_LOAD_PERIOD - 1);
+    CHECK(sched_load()->scans <= SCHED_LOAD_PERIOD + 1);
+    CHECK_EQ(sched_load()->key_scans, 0);
+}
+
+// RCtrl+[: the setting changes at once, the LEDs get there over RGB_FADE_TIME
+static void test_fade(void) {
+    sim_eeprom_erase();
+    sim_reset();
+    user_config.rgb_brightness = 105;
+    user_config_save();
+    user_config_flush();
+    sim_reset();  // boots with it, no fade
+    sim_run_ms(100);
+    CHECK_EQ(sim_frame(sim_frame_count() - 1)->leds[30].r, rgb_power_gamma(105));
+
+    test_key("RCTL", true);
+    sim_run_ms(10);
+    size_t from = sim_frame_count();
+    test_tap("LBRC", 20);
+    CHECK_EQ(user_config.rgb_brightness, 55);
+    test_key("RCTL", false);
+    sim_run_ms(RGB_FADE_TIME + 50);
+
+    uint8_t previous = rgb_power_gamma(105), levels = 0;
+    for (size_t i = from; i < sim_frame_count(); i++) {
+        uint8_t r = sim_frame(i)->leds[30].r;
+        CHECK(r <= previous);
+        levels += r != previous;
+        previous = r;
+    }
+    CHECK(levels > 2);
+    CHECK_EQ(previous, rgb_power_gamma(55));
+}
+
+int main(void) {
+    test_priority_budget();
+    test_keys_first();
+    test_steps();
+    test_period_deadline();
+    test_load();
+    test_fade();
+    TEST_DONE();
+}
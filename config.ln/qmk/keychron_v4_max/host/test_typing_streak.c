@@ -0,0 +1,139 @@
+// Typing streak: the sliding window, the quiet period and what breaks a streak,
+// then end to end: dual-role keys tap on press during a streak and arbitrate
+// normally outside one.
+
+#include "test.h"
+#include "typing_streak.h"
+
+static void type(uint16_t *t, uint16_t keycode, uint16_t gap) {
+    typing_streak_press(keycode, 0, *t);
+    *t += gap;
+}
+
+static void test_window(void) {
+    typing_streak_reset();
+    uint16_t t = 1000;
+    for (int i = 0; i < TYPING_STREAK_KEYS - 1; i++) {
+        type(&t, KC_A + i, 100);
+        CHECK(!typing_streak_active(t));  // not enough presses yet
+    }
+    type(&t, KC_SPC, 100);
+    CHECK(typing_streak_active(t - 100));
+
+    // Quiet period ends it, and the next key starts counting from scratch
+    CHECK(typing_streak_active(t - 100 + TYPING_STREAK_QUIET - 1));
+    CHECK(!typing_streak_active(t - 100 + TYPING_STREAK_QUIET));
+    t += TYPING_STREAK_QUIET;
+    type(&t, KC_A, 50);
+    CHECK(!typing_streak_active(t));
+
+    // Steady but too slow on average (each gap below the quiet period): no streak
+    typing_streak_reset();
+    t = 0;
+    type(&t, KC_A, 240);
+    type(&t, KC_B, 240);
+    type(&t, KC_C, 240);
+    type(&t, KC_D, 0);
+    CHECK(!typing_streak_active(t));
+
+    // The window slides: one quick key brings the average under the interval
+    t += 100;
+    type(&t, KC_E, 0);
+    CHECK(typing_streak_active(t));
+}
+
+static void test_breakers(void) {
+    uint16_t t;
+
+    // Arrows end a streak
+    typing_streak_reset();
+    t = 0;
+    for (int i = 0; i < TYPING_STREAK_KEYS; i++) type(&t, KC_A, 80);
+    CHECK(typing_streak_active(t));
+    type(&t, KC_LEFT, 80);
+    CHECK(!typing_streak_active(t));
+
+    // A letter with Ctrl held is a shortcut, with Shift it is a capital
+    typing_streak_reset();
+    t = 0;
+    for (int i = 0; i < TYPING_STREAK_KEYS; i++) type(&t, KC_A, 80);
+    typing_streak_press(KC_B, MOD_BIT(KC_LSFT), t);
+    CHECK(typing_streak_active(t));
+    typing_streak_press(KC_C, MOD_BIT(KC_LCTL), t);
+    CHECK(!typing_streak_active(t));
+
+    // Modifier keys and dual-role keys under arbitration change nothing
+    typing_streak_reset();
+    t = 0;
+    for (int i = 0; i < TYPING_STREAK_KEYS; i++) type(&t, KC_A, 80);
+    type(&t, KC_LSFT, 10);
+    type(&t, MT(MOD_LCTL, KC_ESC), 10);
+    CHECK(typing_streak_active(t));
+}
+
+static void type_word(void) {
+    static const char *const keys[] = {"T", "H", "E", "SPC"};
+    for (size_t i = 0; i < ARRAY_SIZE(keys); i++) {
+        test_key(keys[i], true);
+        sim_run_ms(40);
+        test_key(keys[i], false);
+        sim_run_ms(30);
+    }
+}
+
+// Enter rolled into A: Enter down, A down, Enter up
+static size_t roll_enter_a(void) {
+    size_t from = sim_report_count();
+    test_key("ENT", true);
+    sim_run_ms(30);
+    test_key("A", true);
+    sim_run_ms(20);
+    test_key("ENT", false);
+    sim_run_ms(30);
+    test_key("A", false);
+    sim_run_ms(30);
+    return from;
+}
+
+static void test_keymap(void) {
+    sim_reset();
+
+    // In a streak: Enter is sent on the same scan as its press, and no Ctrl
+    type_word();
+    uint64_t pressed = sim_now_us();
+    size_t   from    = roll_enter_a();
+    CHECK_EQ(test_find_report(from, KC_ENT, 0), (long)from);
+    CHECK_EQ(sim_report(from)->time_us, pressed);
+    CHECK_EQ(test_find_report(from, KC_NO, MOD_BIT(KC_RCTL)), -1);
+    CHECK(test_find_report(from, KC_A, 0) >= 0);
+
+    // After the quiet period the same roll is RCtrl+A (HOLD_ON_OTHER_KEY_PRESS)
+    sim_run_ms(TYPING_STREAK_QUIET);
+    from = roll_enter_a();
+    CHECK(test_find_report(from, KC_A, MOD_BIT(KC_RCTL)) >= 0);
+    CHECK_EQ(test_find_report(from, KC_ENT, 0), -1);
+
+    // `/VIM in a streak: ` on press, and the VIM layer never comes on
+    sim_run_ms(TYPING_STREAK_QUIET);
+    type_word();
+    pressed = sim_now_us();
+    from    = sim_report_count();
+    test_key("ESC", true);
+    sim_run_ms(30);
+    test_key("J", true);
+    sim_run_ms(20);
+    test_key("ESC", false);
+    test_key("J", false);
+    sim_run_ms(30);
+    CHECK_EQ(test_find_report(from, KC_GRV, 0), (long)from);
+    CHECK_EQ(sim_report(from)->time_us, pressed);
+    CHECK(test_find_report(from, KC_J, 0) >= 0);
+    CHECK_EQ(test_find_report(from, KC_DOWN, 0), -1);
+}
+
+int main(void) {
+    test_window();
+    test_breakers();
+    test_keymap();
+    TEST_DONE();
+}
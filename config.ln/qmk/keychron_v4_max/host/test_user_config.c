@@ -0,0 +1,154 @@
+// Persisted settings: a burst of changes is one EEPROM write made only once the
+// keyboard is quiet, records rotate over the slots, a damaged record falls back
+// to the one before it, and the default layer is repaired once.
+
+#include "test.h"
+#include "rgb_power.h"
+#include "user_config.h"
+
+#define SLOT(i) (sim_eeprom() + (uintptr_t)EECONFIG_USER_DATABLOCK + (i) * USER_CONFIG_RECORD_SIZE)
+
+static void brightness_down(unsigned steps) {
+    test_key("RCTL", true);
+    sim_run_ms(10);
+    for (unsigned i = 0; i < steps; i++) {
+        test_tap("LBRC", 20);
+    }
+    test_key("RCTL", false);
+    sim_run_ms(10);
+}
+
+static uint16_t slot_seq(uint8_t slot) {
+    return (uint16_t)(SLOT(slot)[0] | SLOT(slot)[1] << 8);
+}
+
+static void test_defaults(void) {
+    sim_eeprom_erase();
+    sim_reset();
+    CHECK(!user_config_init());
+    CHECK_EQ(user_config.rgb_brightness, 255);
+    CHECK(user_config.base_rgb_enabled);
+    sim_run_ms(USER_CONFIG_WRITE_DELAY * 2);
+    CHECK_EQ(sim_eeprom_writes(), 0);
+}
+
+static void test_coalesced(void) {
+    sim_eeprom_erase();
+    sim_reset();
+
+    brightness_down(4);
+    CHECK_EQ(user_config.rgb_brightness, 55);
+    CHECK_EQ(sim_eeprom_writes(), 0);
+
+    // Typing keeps pushing the write back
+    for (int i = 0; i < 6; i++) {
+        sim_run_ms(USER_CONFIG_WRITE_DELAY / 2);
+        test_tap("A", 20);
+    }
+    CHECK_EQ(sim_eeprom_writes(), 0);
+
+    sim_run_ms(USER_CONFIG_WRITE_DELAY);
+    CHECK_EQ(sim_eeprom_writes(), 1);
+    CHECK_EQ(user_config_writes(), 1);
+
+    // Survives a power cycle, and the frame shows it
+    sim_reset();
+    CHECK_EQ(user_config.rgb_brightness, 55);
+    sim_run_ms(100);
+    CHECK_EQ(sim_frame(sim_frame_count() - 1)->leds[30].r, rgb_power_gamma(55));
+
+    // Changed and changed back: nothing to write
+    test_key("LCTL", true);
+    sim_run_ms(10);
+    test_tap("BSLS", 20);
+    test_tap("BSLS", 20);
+    test_key("LCTL", false);
+    sim_run_ms(USER_CONFIG_WRITE_DELAY * 2);
+    CHECK_EQ(sim_eeprom_writes(), 1);
+}
+
+static void test_slots(void) {
+    sim_eeprom_erase();
+    sim_reset();
+
+    // Every write goes to the next slot, so each slot takes 1/SLOTS of them
+    for (int i = 0; i < USER_CONFIG_SLOTS * 2; i++) {
+        user_config.rgb_brightness = (uint8_t)(10 + i);
+        user_config_save();
+        user_config_flush();
+    }
+    CHECK_EQ(sim_eeprom_writes(), USER_CONFIG_SLOTS * 2);
+    for (int slot = 0; slot < USER_CONFIG_SLOTS; slot++) {
+        CHECK_EQ(slot_seq(slot), USER_CONFIG_SLOTS + 1 + slot);
+    }
+    uint8_t newest = USER_CONFIG_SLOTS - 1;
+
+    sim_reset();
+    CHECK_EQ(user_config.rgb_brightness, 10 + USER_CONFIG_SLOTS * 2 - 1);
+
+    // A torn write of the newest record: the one before it is used
+    SLOT(newest)[USER_CONFIG_RECORD_SIZE - 1] ^= 0x5A;
+    sim_reset();
+    CHECK_EQ(user_config.rgb_brightness, 10 + USER_CONFIG_SLOTS * 2 - 2);
+
+    // ...and the next save overwrites the damaged slot, not a good one
+    user_config.rgb_brightness = 200;
+    user_config_save();
+    user_config_flush();
+    sim_reset();
+    CHECK_EQ(user_config.rgb_brightness, 200);
+    CHECK_EQ(slot_seq(newest), USER_CONFIG_SLOTS * 2);
+
+    // No valid record at all (e.g. after an older firmware): defaults, and saving works again
+    for (int slot = 0; slot < USER_CONFIG_SLOTS; slot++) {
+        SLOT(slot)[2] = 0;  // version: invalid
+    }
+    sim_reset();
+    CHECK_EQ(user_config.rgb_brightness, 255);
+    for (int i = 0; i < 3; i++) {
+        user_config.rgb_brightness = (uint8_t)(100 + i);
+        user_config_save();
+        user_config_flush();
+    }
+    sim_reset();
+    CHECK_EQ(user_config.rgb_brightness, 102);
+}
+
+static void test_seq_wraps(void) {
+    sim_eeprom_erase();
+    sim_reset();
+    // Walk the sequence number across 0xFFFF -> 0
+    for (uint32_t i = 0; i < 0x10000 + 2; i++) {
+        user_config.rgb_brightness = (uint8_t)i;
+        user_config_save();
+        user_config_flush();
+    }
+    sim_reset();
+    CHECK_EQ(user_config.rgb_brightness, (uint8_t)(0x10000 + 1));
+}
+
+static void test_default_layer_repair(void) {
+    sim_eeprom_erase();
+    sim_eeprom()[(uintptr_t)EECONFIG_DEFAULT_LAYER] = 1 << 1;  // stale _VIM
+    sim_reset();
+    CHECK_EQ(default_layer_state, 1);
+    CHECK_EQ(eeconfig_read_default_layer(), 1);
+    CHECK_EQ(sim_eeprom_writes(), 1);
+
+    size_t from = sim_report_count();
+    test_tap("J", 20);
+    CHECK(test_find_report(from, KC_J, 0) >= 0);
+
+    // Repaired for good: the next boot writes nothing
+    sim_reset();
+    CHECK_EQ(sim_eeprom_writes(), 1);
+}
+
+int main(void) {
+    test_defaults();
+    test_coalesced();
+    test_slots();
+    test_seq_wraps();
+    test_default_layer_repair();
+    TEST_DONE();
+}
@@ -0,0 +1,120 @@
+// Host driver shim, see host_shim.h.
+
+#include QMK_KEYBOARD_H
+#include "fast_wake.h"
+#include "host_shim.h"
+#include "latency_trace.h"
+#ifdef REPORT_QUEUE_ENABLE
+#    include "report_queue.h"
+#endif
+
+static host_driver_t *transport;
+
+// ---------------------------------------------------------------------------
+// Last stop before the transport
+
+static uint8_t out_keyboard_leds(void) {
+    return transport->keyboard_leds();
+}
+
+// A report the transport would drop (not connected yet) is kept for fast_wake to
+// replay. It still goes out: on wireless, that is what starts the reconnect.
+#define OUT_SEND(kind, report)                  \
+    do {                                        \
+        LATENCY_TRACE(LT_SENT, LT_KEY_NONE);    \
+        if (fast_wake_replay(transport)) {      \
+            fast_wake_mark(WAKE_FIRST_REPORT);  \
+        } else {                                \
+            fast_wake_hold_##kind(report);      \
+        }                                       \
+        transport->send_##kind(report);         \
+    } while (0)
+
+static void out_send_keyboard(report_keyboard_t *report) {
+    OUT_SEND(keyboard, report);
+}
+
+static void out_send_nkro(report_nkro_t *report) {
+    OUT_SEND(nkro, report);
+}
+
+static void out_send_mouse(report_mouse_t *report) {
+    transport->send_mouse(report);
+}
+
+static void out_send_extra(report_extra_t *report) {
+    OUT_SEND(extra, report);
+}
+
+#ifdef REPORT_QUEUE_ENABLE
+static host_driver_t out_driver = {
+    .keyboard_leds = out_keyboard_leds,
+    .send_keyboard = out_send_keyboard,
+    .send_nkro     = out_send_nkro,
+    .send_mouse    = out_send_mouse,
+    .send_extra    = out_send_extra,
+};
+#endif
+
+// ---------------------------------------------------------------------------
+// What QMK sees as the host driver
+
+#ifdef REPORT_QUEUE_ENABLE
+// Batch while report_queue_batching() says so; otherwise anything still queued
+// goes out first so reports never overtake each other.
+#    define SHIM_SEND(kind, report)                       \
+        do {                                              \
+            if (report_queue_batching()) {                \
+                report_queue_##kind(report, &out_driver); \
+                return;                                   \
+            }                                             \
+            report_queue_flush(&out_driver);              \
+            out_send_##kind(report);                      \
+        } while (0)
+#else
+#    define SHIM_SEND(kind, report) out_send_##kind(report)
+#endif
+
+static void shim_send_keyboard(report_keyboard_t *report) {
+    LATENCY_TRACE(LT_REPORT, LT_KEY_NONE);
+    SHIM_SEND(keyboard, report);
+}
+
+static void shim_send_nkro(report_nkro_t *report) {
+    LATENCY_TRACE(LT_REPORT, LT_KEY_NONE);
+    SHIM_SEND(nkro, report);
+}
+
+static void shim_send_mouse(report_mouse_t *report) {
+#ifdef REPORT_QUEUE_ENABLE
+    report_queue_flush(&out_driver);
+#endif
+    out_send_mouse(report);
+}
+
+static void shim_send_extra(report_extra_t *report) {
+    LATENCY_TRACE(LT_REPORT, LT_KEY_NONE);
+    SHIM_SEND(extra, report);
+}
+
+static host_driver_t shim_driver = {
+    .keyboard_leds = out_keyboard_leds,
+    .send_keyboard = shim_send_keyboard,
+    .send_nkro     = shim_send_nkro,
+    .send_mouse    = shim_send_mouse,
+    .send_extra    = shim_send_extra,
+};
+
+void host_shim_task(void) {
+    host_driver_t *current = host_get_driver();
+    if (current && current != &shim_driver) {
+        transport = current;
+        host_set_driver(&shim_driver);
+    }
+    if (transport) {
+        fast_wake_replay(transport);
+#ifdef REPORT_QUEUE_ENABLE
+        report_queue_flush(&out_driver);
+#endif
+    }
+}
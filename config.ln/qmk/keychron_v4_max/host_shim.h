@@ -0,0 +1,13 @@
+// Host driver shim: sits between QMK's report path and the active transport
+// driver so reports can be timestamped (LATENCY_TRACE_ENABLE), batched per
+// scan (REPORT_QUEUE_ENABLE) and held for replay while the transport is not
+// connected (fast_wake.h) on their way out. Always built: the wake replay needs it
+// even with both options off.
+
+#pragma once
+
+// Installs the shim in front of whatever driver is current. Keychron's wireless
+// code swaps drivers when the transport changes (USB, Bluetooth, 2.4 GHz), so
+// this is also called from housekeeping to re-wrap the new one. It then replays
+// reports held while the transport was down and flushes those queued during the scan.
+void host_shim_task(void);
@@ -2,6 +2,21 @@
 // Based on Karabiner config and GK6X configuration (655491117.txt)
 
 #include QMK_KEYBOARD_H
+#include <string.h>
+#include "adaptive_tapping.h"
+#include "fast_wake.h"
+#include "host_shim.h"
+#include "latency_trace.h"
+#include "overrides.h"
+#include "sched.h"
+#include "typing_streak.h"
+#include "user_config.h"
+#ifdef RGB_MATRIX_ENABLE
+#    include "rgb_power.h"
+#endif
+#ifdef REPORT_QUEUE_ENABLE
+#    include "report_queue.h"
+#endif
 
 // Layer definitions
 enum layers {
@@ -119,231 +134,589 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
     )
 };
 
-// Force default layer to BASE on boot. Without this, a stale default_layer_state
-// in EEPROM (e.g. set to _VIM) causes keystrokes to resolve through VIM even
-// though layer_state shows BASE — symptom: RGB looks like base, keys behave like VIM.
-void keyboard_post_init_user(void) {
-    default_layer_set((layer_state_t)1 << _BASE);
-    layer_clear();
+#ifdef LK_WIRELESS_ENABLE
+// Bluetooth/2.4 GHz drop reports until connected; fast_wake replays them then
+bool fast_wake_transport_ready(void) {
+    return get_transport() == TRANSPORT_USB || wireless_get_state() == WT_CONNECTED;
+}
+#endif
+
+#if defined(RGB_MATRIX_ENABLE) && defined(LK_WIRELESS_ENABLE)
+bool rgb_power_on_battery(void) {
+    return !usb_power_connected();
+}
+#endif
+
+#if defined(REPORT_QUEUE_ENABLE) && defined(LK_WIRELESS_ENABLE)
+// USB reports are cheap; batch only when they go over the radio
+bool report_queue_batching(void) {
+    return get_transport() != TRANSPORT_USB;
+}
+#endif
+
+#ifdef LATENCY_TRACE_ENABLE
+void matrix_scan_user(void) {
+    latency_trace_matrix_scan();
 }
 
-// State tracking for Ctrl keys and RGB toggle
+void raw_hid_receive(uint8_t *data, uint8_t length) {
+    if (latency_trace_raw_hid(data, length)) {
+        raw_hid_send(data, length);
+    }
+}
+#endif
+
+// State tracking for Ctrl keys. The base RGB toggle and brightness (RCtrl+[/])
+// live in user_config so they survive a power cycle.
 static bool lctrl_pressed = false;  // Physical left ctrl
 static bool rctrl_pressed = false;  // Physical right ctrl
-static bool base_rgb_enabled = true;   // Toggle for base layer RGB
-static uint8_t rgb_brightness = 255;   // Base layer brightness (0-255, adjustable with RCtrl+[/])
-// Handle Ctrl + combinations and numpad layer special keys
-bool process_record_user(uint16_t keycode, keyrecord_t *record) {
 
+// Highest active layer, cached by layer_state_set_user so the per-key paths
+// (combo dispatch, RGB frame) never recompute it.
+static uint8_t current_layer = _BASE;
+
+#ifdef RGB_MATRIX_ENABLE
+// Cached indicator frame (see rgb_matrix_indicators_advanced_user). Anything that
+// changes what the LEDs should show marks it stale and wakes the rebuild task,
+// which runs in the next scan without key events (sched.h).
+static bool    rgb_frame_dirty   = true;
+static uint8_t rgb_rebuild_task  = SCHED_NONE;
+static inline void rgb_frame_invalidate(void) {
+    rgb_frame_dirty = true;
+    sched_wake(rgb_rebuild_task, 0);
+}
+static void rgb_frame_init(void);
+static void rgb_frame_prepare(void);
+static void rgb_housekeeping(void);
+static void rgb_fade_start(void);
+#else
+static inline void rgb_frame_invalidate(void) {}
+static inline void rgb_frame_init(void) {}
+static inline void rgb_frame_prepare(void) {}
+static inline void rgb_housekeeping(void) {}
+static inline void rgb_fade_start(void) {}
+#endif
+
+// Boot check-and-repair. A stale default_layer_state in EEPROM (e.g. set to _VIM)
+// makes keystrokes resolve through VIM even though layer_state shows BASE —
+// symptom: RGB looks like base, keys behave like VIM. Only BASE (or nothing,
+// which also resolves to BASE) is valid; anything else is fixed in EEPROM too,
+// so the write happens once rather than being papered over on every boot.
+// Only what key handling needs runs here; the RGB matrix comes up on later scans
+// (fast_wake.h).
+void keyboard_post_init_user(void) {
+    fast_wake_start();
+    sched_init();
+    if (default_layer_state & ~((layer_state_t)1 << _BASE)) {
+        default_layer_set((layer_state_t)1 << _BASE);
+        eeconfig_update_default_layer(1 << _BASE);
+    }
+    layer_clear();
+    user_config_init();
+    rgb_frame_init();
+#ifdef LATENCY_TRACE_ENABLE
+    latency_trace_init();
+#endif
+    host_shim_task();
+    fast_wake_mark(WAKE_INPUT_READY);
+}
+
+
+// Re-wraps the transport if the wireless code switched it, flushes queued
+// reports, brings RGB up after boot/wake, runs the RGB idle/battery handling and
+// the background tasks, and writes pending settings.
+void housekeeping_task_user(void) {
+    host_shim_task();
+    switch (fast_wake_task()) {
+        case WAKE_RGB_PREPARE:
+            rgb_frame_prepare();
+            break;
+        case WAKE_RGB_RUNNING:
+            rgb_housekeeping();
+            sched_task();
+            break;
+        default:
+            break;
+    }
+    user_config_task();
+}
+
+// Don't lose a brightness change still waiting for its quiet period
+void suspend_power_down_user(void) {
+    user_config_flush();
+}
+
+// USB resume or wireless wake: same order as at power-on, keys before RGB
+void suspend_wakeup_init_user(void) {
+    fast_wake_start();
+    rgb_frame_invalidate();
+    fast_wake_mark(WAKE_INPUT_READY);
+}
+
+layer_state_t layer_state_set_user(layer_state_t state) {
+    uint8_t layer = get_highest_layer(state);
+    if (layer != current_layer) {
+        current_layer = layer;
+        rgb_frame_invalidate();
+    }
+    return state;
+}
+
+// Dual-role keys with their own tapping term (config.h), learned per key when
+// ADAPTIVE_TAPPING_TERM is on.
+static uint8_t tapping_slot(uint16_t keycode) {
+    switch (keycode) {
+        case MT(MOD_LCTL, KC_ESC):
+            return TAP_SLOT_ESC_CTRL;
+        case MT(MOD_RCTL, KC_ENT):
+            return TAP_SLOT_ENT_CTRL;
+        case LT(_VIM, KC_GRV):
+            return TAP_SLOT_GRV_VIM;
+    }
+    return TAP_SLOT_COUNT;
+}
+
+static const uint16_t configured_terms[TAP_SLOT_COUNT] = {
+    [TAP_SLOT_ESC_CTRL] = TAPPING_TERM_ESC_CTRL,
+    [TAP_SLOT_ENT_CTRL] = TAPPING_TERM_ENT_CTRL,
+    [TAP_SLOT_GRV_VIM]  = TAPPING_TERM_GRV_VIM,
+};
+
+uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record) {
+    uint8_t slot = tapping_slot(keycode);
+    if (slot == TAP_SLOT_COUNT) {
+        return TAPPING_TERM;
+    }
+#ifdef ADAPTIVE_TAPPING_TERM
+    return adaptive_tapping_term(slot, configured_terms[slot]);
+#else
+    return configured_terms[slot];
+#endif
+}
+
+#ifdef ADAPTIVE_TAPPING_TERM
+// Feed press durations of the dual-role keys to the adaptive term. Tap/hold keys
+// reach process_record_user only once resolved, but their press record still
+// carries the physical press time.
+static void track_tapping(uint16_t keycode, keyrecord_t *record) {
+    uint8_t slot = tapping_slot(keycode);
+    if (slot == TAP_SLOT_COUNT) {
+        if (record->event.pressed) adaptive_tapping_other_key();
+    } else if (record->event.pressed) {
+        adaptive_tapping_press(slot, record->event.time);
+    } else {
+        adaptive_tapping_release(slot, record->event.time, record->tap.count > 0, configured_terms[slot]);
+    }
+}
+#endif
+
+// Ctrl + key commands and numpad layer special keys.
+//
+// KEYMAP_COMBOS is the declarative list: one row per keycode, giving the action
+// per layer with Ctrl up and with Ctrl held (either physical Ctrl). It expands at
+// compile time into combo_actions[slot][ctrl][layer], so every key event is one
+// lookup in combo_slots[] (by low byte, checked against the full keycode) and,
+// for combo keys only, one lookup in combo_actions[].
+enum combo_action {
+    ACT_NONE = 0,  // default handling
+    // Run on press and release
+    ACT_TRACK_LCTRL,
+    ACT_TRACK_RCTRL,
+    // Run on press only
+    ACT_FIRST_PRESS_ONLY,
+    ACT_BLUETOOTH_LAYER = ACT_FIRST_PRESS_ONLY,
+    ACT_TOGGLE_BASE_RGB,
+    ACT_BRIGHTNESS_DOWN,
+    ACT_BRIGHTNESS_UP,
+    ACT_BASE_LAYER,
+    ACT_VIM_LAYER,
+    ACT_NUMPAD_LAYER,
+};
+
+#define LAYER_COUNT 4
+#define LAYER_MASK(layer) (1u << (layer))
+#define ALL_LAYERS ((1u << LAYER_COUNT) - 1)
+#define NO_LAYERS 0u
+#define ON_LAYERS(mask, action) \
+    { (mask) & LAYER_MASK(0) ? (action) : ACT_NONE, (mask) & LAYER_MASK(1) ? (action) : ACT_NONE, \
+      (mask) & LAYER_MASK(2) ? (action) : ACT_NONE, (mask) & LAYER_MASK(3) ? (action) : ACT_NONE }
+#define NEVER ON_LAYERS(NO_LAYERS, ACT_NONE)
+
+_Static_assert(_BLUETOOTH + 1 == LAYER_COUNT, "ON_LAYERS expands exactly LAYER_COUNT layers");
+
+// clang-format off
+#define KEYMAP_COMBOS(X) \
+    /* name    keycode            Ctrl up                                      Ctrl held                                   */ \
+    X(LCTL,    KC_LCTL,           ON_LAYERS(ALL_LAYERS, ACT_TRACK_LCTRL),      ON_LAYERS(ALL_LAYERS, ACT_TRACK_LCTRL))      \
+    X(RCTL,    KC_RCTL,           ON_LAYERS(ALL_LAYERS, ACT_TRACK_RCTRL),      ON_LAYERS(ALL_LAYERS, ACT_TRACK_RCTRL))      \
+    X(GRV_VIM, LT(_VIM, KC_GRV),  NEVER,                                       ON_LAYERS(ALL_LAYERS, ACT_BLUETOOTH_LAYER))  \
+    X(BSLS,    KC_BSLS,           NEVER,                                       ON_LAYERS(ALL_LAYERS, ACT_TOGGLE_BASE_RGB))  \
+    X(LBRC,    KC_LBRC,           NEVER,                                       ON_LAYERS(ALL_LAYERS, ACT_BRIGHTNESS_DOWN))  \
+    X(RBRC,    KC_RBRC,           NEVER,                                       ON_LAYERS(ALL_LAYERS, ACT_BRIGHTNESS_UP))    \
+    X(Q,       KC_Q,              NEVER,                                       ON_LAYERS(ALL_LAYERS, ACT_BASE_LAYER))       \
+    X(W,       KC_W,              NEVER,                                       ON_LAYERS(ALL_LAYERS, ACT_BASE_LAYER))       \
+    X(E,       KC_E,              NEVER,                                       ON_LAYERS(ALL_LAYERS, ACT_VIM_LAYER))        \
+    X(R,       KC_R,              NEVER,                                       ON_LAYERS(ALL_LAYERS, ACT_NUMPAD_LAYER))
+// clang-format on
+
+#define COMBO_SLOT_ENUM(name, keycode, ctrl_up, ctrl_held) COMBO_##name,
+#define COMBO_SLOT_INDEX(name, keycode, ctrl_up, ctrl_held) [(keycode) & 0xFF] = COMBO_##name,
+#define COMBO_KEYCODE(name, keycode, ctrl_up, ctrl_held) [COMBO_##name] = (keycode),
+#define COMBO_ACTIONS(name, keycode, ctrl_up, ctrl_held) [COMBO_##name] = {ctrl_up, ctrl_held},
+#define COMBO_SLOT_CASE(name, keycode, ctrl_up, ctrl_held) case (keycode) & 0xFF:;
+
+enum combo_slot { COMBO_NONE = 0, KEYMAP_COMBOS(COMBO_SLOT_ENUM) COMBO_SLOT_COUNT };
+
+// Indexed by the keycode's low byte. Two combo keycodes sharing one would be
+// duplicate case labels below, a compile error in every build, so this stays a
+// perfect hash. Never called.
+static inline void combo_slots_unique(int keycode) {
     switch (keycode) {
-        case KC_LCTL:
+        KEYMAP_COMBOS(COMBO_SLOT_CASE)
+    }
+}
+
+static const uint8_t  combo_slots[256] PROGMEM                                = {KEYMAP_COMBOS(COMBO_SLOT_INDEX)};
+static const uint16_t combo_keycodes[COMBO_SLOT_COUNT] PROGMEM                = {KEYMAP_COMBOS(COMBO_KEYCODE)};
+static const uint8_t  combo_actions[COMBO_SLOT_COUNT][2][LAYER_COUNT] PROGMEM = {KEYMAP_COMBOS(COMBO_ACTIONS)};
+
+// Keys rewritten in place (overrides.h): the replacement and its modifiers go
+// out in one report on press and one on release, and the key repeats while held.
+// clang-format off
+const override_rule_t override_rules[] PROGMEM = {
+    // In numpad layer: Shift + . (the physical / key) produces / for division
+    {.layers = LAYER_MASK(_NUMPAD), .trigger = KC_DOT, .required_mods = MOD_MASK_SHIFT,
+     .suppressed_mods = MOD_MASK_SHIFT, .replacement = KC_SLSH},
+    // In numpad layer: \ produces /
+    {.layers = LAYER_MASK(_NUMPAD), .trigger = KC_BSLS, .ctrl = OVERRIDE_CTRL_UP, .replacement = KC_SLSH},
+    // Ctrl + / = Up arrow (only when not in numpad layer)
+    {.layers = ALL_LAYERS & ~LAYER_MASK(_NUMPAD), .trigger = KC_SLSH, .ctrl = OVERRIDE_CTRL_HELD, .replacement = KC_UP},
+};
+// clang-format on
+const uint8_t override_rule_count = ARRAY_SIZE(override_rules);
+
+static uint8_t combo_action(uint16_t keycode) {
+    uint8_t slot = pgm_read_byte(&combo_slots[keycode & 0xFF]);
+    if (slot == COMBO_NONE || pgm_read_word(&combo_keycodes[slot]) != keycode || current_layer >= LAYER_COUNT) {
+        return ACT_NONE;
+    }
+    return pgm_read_byte(&combo_actions[slot][lctrl_pressed || rctrl_pressed][current_layer]);
+}
+
+static bool process_record_keymap(uint16_t keycode, keyrecord_t *record) {
+    // Overrides first: a key overridden on press must be released through them
+    // even if Ctrl or the layer changed in between.
+    if (!process_overrides(keycode, record, current_layer, lctrl_pressed || rctrl_pressed)) {
+        return false;
+    }
+
+    uint8_t action = combo_action(keycode);
+    if (action == ACT_NONE || (action >= ACT_FIRST_PRESS_ONLY && !record->event.pressed)) {
+        return true;
+    }
+
+    switch (action) {
+        case ACT_TRACK_LCTRL:
             lctrl_pressed = record->event.pressed;
+            rgb_frame_invalidate();
             return true;
 
-        case KC_RCTL:
+        case ACT_TRACK_RCTRL:
             rctrl_pressed = record->event.pressed;
+            rgb_frame_invalidate();
             return false;  // Don't send to OS - only used for custom combos (arrows, layer switching)
 
-        case LT(_VIM, KC_GRV):
+        case ACT_BLUETOOTH_LAYER:
             // Ctrl + ` = Switch to Bluetooth layer
-            if ((lctrl_pressed || rctrl_pressed) && record->event.pressed) {
-                layer_clear();
-                layer_on(_BLUETOOTH);
-                return false;
-            }
-            return true;
+            layer_clear();
+            layer_on(_BLUETOOTH);
+            return false;
 
-        case KC_DOT:
-            // In numpad layer: Shift+/ (?) produces / for division
-            if (get_highest_layer(layer_state) == _NUMPAD &&
-                get_mods() & MOD_MASK_SHIFT &&
-                record->event.pressed) {
-                // Remove shift, send slash, restore shift
-                uint8_t mods = get_mods();
-                del_mods(MOD_MASK_SHIFT);
-                tap_code(KC_SLSH);
-                set_mods(mods);
-                return false;
-            }
-            return true;
-
-        case KC_BSLS:
+        case ACT_TOGGLE_BASE_RGB:
             // Ctrl + \ = Toggle base layer RGB
-            if ((lctrl_pressed || rctrl_pressed) && record->event.pressed) {
-                base_rgb_enabled = !base_rgb_enabled;
-                return false;
-            }
-            // In numpad layer: \ produces /
-            if (get_highest_layer(layer_state) == _NUMPAD && record->event.pressed) {
-                tap_code(KC_SLSH);
-                return false;
-            }
-            return true;
-
-        case KC_SLSH:
-            // Ctrl + / = Up arrow (only when not in numpad layer)
-            if ((lctrl_pressed || rctrl_pressed) && record->event.pressed &&
-                get_highest_layer(layer_state) != _NUMPAD) {
-                tap_code(KC_UP);
-                return false;
-            }
-            return true;
+            user_config.base_rgb_enabled = !user_config.base_rgb_enabled;
+            user_config_save();
+            rgb_frame_invalidate();
+            return false;
 
-        case KC_LBRC:
+        case ACT_BRIGHTNESS_DOWN:
             // RCtrl + [ = RGB brightness down
-            if ((lctrl_pressed || rctrl_pressed) && record->event.pressed) {
-                if (rgb_brightness >= 50) rgb_brightness -= 50;
-                else rgb_brightness = 0;
-                return false;
-            }
-            return true;
+            if (user_config.rgb_brightness >= 50) user_config.rgb_brightness -= 50;
+            else user_config.rgb_brightness = 0;
+            user_config_save();
+            rgb_fade_start();
+            return false;
 
-        case KC_RBRC:
+        case ACT_BRIGHTNESS_UP:
             // RCtrl + ] = RGB brightness up
-            if ((lctrl_pressed || rctrl_pressed) && record->event.pressed) {
-                if (rgb_brightness <= 205) rgb_brightness += 50;
-                else rgb_brightness = 255;
-                return false;
-            }
-            return true;
+            if (user_config.rgb_brightness <= 205) user_config.rgb_brightness += 50;
+            else user_config.rgb_brightness = 255;
+            user_config_save();
+            rgb_fade_start();
+            return false;
 
-        case KC_Q:
-        case KC_W:
+        case ACT_BASE_LAYER:
             // Ctrl + Q or W = Switch to Base layer
-            if ((lctrl_pressed || rctrl_pressed) && record->event.pressed) {
-                layer_clear();
-                return false;
-            }
-            return true;
+            layer_clear();
+            return false;
 
-        case KC_E:
+        case ACT_VIM_LAYER:
             // Ctrl + E = Switch to VIM layer
-            if ((lctrl_pressed || rctrl_pressed) && record->event.pressed) {
-                layer_clear();
-                layer_on(_VIM);
-                return false;
-            }
-            return true;
+            layer_clear();
+            layer_on(_VIM);
+            return false;
 
-        case KC_R:
+        case ACT_NUMPAD_LAYER:
             // Ctrl + R = Switch to Numpad layer
-            if ((lctrl_pressed || rctrl_pressed) && record->event.pressed) {
-                layer_clear();
-                layer_on(_NUMPAD);
-                return false;
-            }
+            layer_clear();
+            layer_on(_NUMPAD);
+            return false;
+    }
+    return true;
+}
+
+// Dual-role keys resolved to their tap by a typing streak, until released. Their
+// events never reach tap/hold arbitration or process_record_user.
+static matrix_row_t streak_taps[MATRIX_ROWS];
+// Dual-role keys held and left to normal arbitration. No instant taps meanwhile:
+// they would overtake the key events arbitration is still holding back.
+static uint8_t arbitrating;
+
+static uint8_t dual_role_tap(uint16_t keycode) {
+    return IS_QK_MOD_TAP(keycode) ? QK_MOD_TAP_GET_TAP_KEYCODE(keycode) : QK_LAYER_TAP_GET_TAP_KEYCODE(keycode);
+}
+
+// Every key event, before tap/hold arbitration: activity for the idle timers,
+// and the typing streak. During a streak Esc/Ctrl, Enter/Ctrl and `/VIM send
+// their tap on press instead of waiting for arbitration.
+bool pre_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    keypos_t     key     = record->event.key;
+    matrix_row_t bit     = (matrix_row_t)1 << key.col;
+    bool         pressed = record->event.pressed;
+
+    user_config_activity();
+    fast_wake_key_event();
+    sched_key_event();
+#ifdef RGB_MATRIX_ENABLE
+    if (pressed) {
+        rgb_power_activity();
+    }
+#endif
+
+    if (streak_taps[key.row] & bit) {
+        streak_taps[key.row] &= ~bit;
+        unregister_code(dual_role_tap(keycode));
+        return false;
+    }
+    if (tapping_slot(keycode) != TAP_SLOT_COUNT) {
+        if (!pressed) {
+            if (arbitrating) arbitrating--;
             return true;
+        }
+        // The Ctrl keys are tracked apart from the mods (ACT_TRACK_*), so check them too:
+        // physical Ctrl + a dual-role key is a layer or override chord, never a plain tap
+        bool ctrl = lctrl_pressed || rctrl_pressed;
+        if (!arbitrating && !ctrl && !(get_mods() & ~MOD_MASK_SHIFT) && typing_streak_active(record->event.time)) {
+            uint8_t tap = dual_role_tap(keycode);
+            LATENCY_TRACE(LT_TAP_RESOLVED, LT_KEY(key.row, key.col));
+            streak_taps[key.row] |= bit;
+            typing_streak_press(tap, get_mods(), record->event.time);
+            register_code(tap);
+            return false;
+        }
+        arbitrating++;
+    }
+    if (pressed) {
+        typing_streak_press(keycode, get_mods(), record->event.time);
     }
     return true;
 }
 
+// Latency trace stamps around the keymap's own handling (no-ops unless enabled)
+bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    uint8_t trace_key = LT_KEY(record->event.key.row, record->event.key.col);
+    if (record->event.pressed && (IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode))) {
+        LATENCY_TRACE(LT_TAP_RESOLVED, trace_key);
+    }
+    LATENCY_TRACE(LT_PRU_ENTER, trace_key);
+#ifdef ADAPTIVE_TAPPING_TERM
+    track_tapping(keycode, record);
+#endif
+    bool proceed = process_record_keymap(keycode, record);
+    LATENCY_TRACE(LT_PRU_EXIT, trace_key);
+    return proceed;
+}
+
 // RGB lighting layer indication (matches GK6X lighting config)
 #ifdef RGB_MATRIX_ENABLE
 
+typedef struct {
+    uint8_t led;
+    uint8_t r, g, b;
+} led_color_t;
+
 // Per-key RGB colors for VIM layer (from GK6X vimLike.le)
 // LED indices verified from g_led_config in ansi.c (2026-02-01)
-bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
-    if (get_highest_layer(layer_state) == _VIM) {
-        // Turn off all keys first
-        for (uint8_t i = led_min; i < led_max; i++) {
-            rgb_matrix_set_color(i, 0, 0, 0);
-        }
-
-        // S & D (layer switching): Dark blue 0x020020
-        rgb_matrix_set_color(30, 2, 0, 32);  // S (was 29, fixed to 30)
-        rgb_matrix_set_color(31, 2, 0, 32);  // D (was 30, fixed to 31)
+static const led_color_t PROGMEM vim_leds[] = {
+    {30,   2,   0,  32}, {31,   2,   0,  32},                      // S, D (layer switching): dark blue 0x020020
+    { 8, 255, 255, 255}, { 9, 255, 255, 255}, {10, 255, 255, 255}, // 8, 9, 0 (volume controls): white 0xFFFFFF
+    {21, 255, 165,   0}, {22, 255, 165,   0},                      // U, I (Page Up/Down): orange 0xFFA500
+    {48,   0, 255,   0}, {49,   0, 255,   0},                      // M, Comma (Home/End): green 0x00FF00
+    {13, 255,   0,   0},                                           // Backspace (Forward Delete): red 0xFF0000
+    {34, 128,   0, 128}, {35, 128,   0, 128},                      // H, J (arrow keys): purple 0x800080
+    {36, 128,   0, 128}, {37, 128,   0, 128},                      // K, L
+};
 
-        // 8, 9, 0 (volume controls): White 0xFFFFFF
-        rgb_matrix_set_color(8, 255, 255, 255);   // 8
-        rgb_matrix_set_color(9, 255, 255, 255);   // 9
-        rgb_matrix_set_color(10, 255, 255, 255);  // 0
+// Per-key RGB colors for NUMPAD layer (from GK6X numpad.le)
+static const led_color_t PROGMEM numpad_leds[] = {
+    {30,   2,   0,  32}, {31,   2,   0,  32},                      // S, D (layer switching): dark blue 0x020020
+    {21, 128,   0, 128}, {22, 128,   0, 128}, {23, 128,   0, 128}, // U, I, O (7, 8, 9): purple 0x800080
+    {35, 128,   0, 128}, {36, 128,   0, 128}, {37, 128,   0, 128}, // J, K, L (4, 5, 6)
+    {48, 128,   0, 128}, {49, 128,   0, 128}, {50, 128,   0, 128}, // M, Comma, Period (1, 2, 3)
+    {47,   0, 255,   0},                                           // N (0): green 0x00FF00
+    {38, 255,   0,   0}, {51, 255,   0,   0},                      // Semicolon, Slash (numpad comma/period): red
+    {27, 255,   0,   0},                                           // Backslash (division): red
+};
 
-        // U & I (Page Up/Down): Orange 0xFFA500
-        rgb_matrix_set_color(21, 255, 165, 0);  // U
-        rgb_matrix_set_color(22, 255, 165, 0);  // I
+// Bluetooth pairing indicators in cyan (0x00FFFF)
+static const led_color_t PROGMEM bluetooth_leds[] = {
+    {15, 0, 255, 255}, {16, 0, 255, 255}, {17, 0, 255, 255}, // Q, W, E (Fn1+Q/W/E = BT device 1/2/3)
+    {58, 0, 255, 255},                                       // Fn1 (Bluetooth/media/RGB control key)
+};
 
-        // M & Comma (Home/End): Green 0x00FF00
-        rgb_matrix_set_color(48, 0, 255, 0);  // M (was 47, fixed to 48)
-        rgb_matrix_set_color(49, 0, 255, 0);  // Comma (was 48, fixed to 49)
+// Visual indicator: ESC/Q/W/E/R in red when physical Ctrl is pressed (all layers)
+// Shows available layer switching keys: Ctrl+Esc/Q/W/E/R
+static const led_color_t PROGMEM ctrl_leds[] = {
+    { 0, 255, 0, 0},  // ESC (Ctrl+Esc → Bluetooth)
+    {15, 255, 0, 0},  // Q (Ctrl+Q → Base)
+    {16, 255, 0, 0},  // W (Ctrl+W → Base)
+    {17, 255, 0, 0},  // E (Ctrl+E → VIM)
+    {18, 255, 0, 0},  // R (Ctrl+R → Numpad)
+};
 
-        // Backspace (Forward Delete): Red 0xFF0000
-        rgb_matrix_set_color(13, 255, 0, 0);  // Backspace
+typedef struct {
+    const led_color_t *leds;
+    uint8_t            count;
+} led_table_t;
+
+// Indexed by layer. BASE has no per-key table: it is a solid fill (see rgb_frame_rebuild).
+static const led_table_t PROGMEM layer_led_tables[] = {
+    [_BASE]      = {NULL, 0},
+    [_VIM]       = {vim_leds, ARRAY_SIZE(vim_leds)},
+    [_NUMPAD]    = {numpad_leds, ARRAY_SIZE(numpad_leds)},
+    [_BLUETOOTH] = {bluetooth_leds, ARRAY_SIZE(bluetooth_leds)},
+};
 
-        // H, J, K, L (arrow keys): Purple 0x800080
-        rgb_matrix_set_color(34, 128, 0, 128);  // H (was 33, fixed to 34)
-        rgb_matrix_set_color(35, 128, 0, 128);  // J (was 34, fixed to 35)
-        rgb_matrix_set_color(36, 128, 0, 128);  // K (was 35, fixed to 36)
-        rgb_matrix_set_color(37, 128, 0, 128);  // L (was 36, fixed to 37)
+#ifndef RGB_FADE_TIME
+#    define RGB_FADE_TIME 120  // ms for a brightness change to fade in
+#endif
+#define RGB_FADE_INTERVAL 10  // ms per fade step
+
+// Two frames: the rebuild task writes the back one from housekeeping and the RGB
+// task switches to it at the start of a flush, so one flush never mixes two frames.
+static uint8_t rgb_frames[2][RGB_MATRIX_LED_COUNT][3];
+static uint8_t rgb_front;  // the frame the RGB task reads
+static bool    rgb_back_ready;
+
+// Brightness the frame shows, fading towards user_config.rgb_brightness (RCtrl+[/])
+static uint8_t rgb_brightness_shown;
+static uint8_t rgb_fade_step;
+static uint8_t rgb_fade_task = SCHED_NONE;
+
+static void rgb_frame_apply(uint8_t frame[][3], const led_color_t *leds, uint8_t count, uint8_t level) {
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t led = pgm_read_byte(&leds[i].led);
+        frame[led][0] = rgb_power_scale(pgm_read_byte(&leds[i].r), level);
+        frame[led][1] = rgb_power_scale(pgm_read_byte(&leds[i].g), level);
+        frame[led][2] = rgb_power_scale(pgm_read_byte(&leds[i].b), level);
+    }
+}
 
-    } else if (get_highest_layer(layer_state) == _NUMPAD) {
-        // Turn off all keys first
-        for (uint8_t i = led_min; i < led_max; i++) {
-            rgb_matrix_set_color(i, 0, 0, 0);
-        }
+// Recompute the whole frame from the current layer, Ctrl, base RGB settings and
+// the power state (rgb_power.h). Only runs when one of those changed, not on
+// every RGB tick.
+static void rgb_frame_rebuild(void) {
+    uint8_t(*frame)[3] = rgb_frames[rgb_front ^ 1];
+    uint8_t fill       = 0;
+    if (current_layer == _BASE && user_config.base_rgb_enabled) {
+        fill = rgb_power_scale(rgb_power_gamma(rgb_brightness_shown), rgb_power_fill_level());
+    }
+    memset(frame, fill, sizeof(rgb_frames[0]));
 
-        // S & D (layer switching): Dark blue 0x020020
-        rgb_matrix_set_color(30, 2, 0, 32);  // S
-        rgb_matrix_set_color(31, 2, 0, 32);  // D
-
-        // Numbers 1-9 (U, I, O, J, K, L, M, Comma, Period): Purple 0x800080
-        rgb_matrix_set_color(21, 128, 0, 128);  // U (7)
-        rgb_matrix_set_color(22, 128, 0, 128);  // I (8)
-        rgb_matrix_set_color(23, 128, 0, 128);  // O (9)
-        rgb_matrix_set_color(35, 128, 0, 128);  // J (4)
-        rgb_matrix_set_color(36, 128, 0, 128);  // K (5)
-        rgb_matrix_set_color(37, 128, 0, 128);  // L (6)
-        rgb_matrix_set_color(48, 128, 0, 128);  // M (1)
-        rgb_matrix_set_color(49, 128, 0, 128);  // Comma (2)
-        rgb_matrix_set_color(50, 128, 0, 128);  // Period (3)
-
-        // Number 0 (N): Green 0x00ff00
-        rgb_matrix_set_color(47, 0, 255, 0);  // N (0)
-
-        // Semicolon and Slash (numpad comma/period): Red 0xFF0000
-        rgb_matrix_set_color(38, 255, 0, 0);  // Semicolon (numpad comma)
-        rgb_matrix_set_color(51, 255, 0, 0);  // Slash (numpad period)
-
-        // Backslash (division): Red 0xFF0000
-        rgb_matrix_set_color(27, 255, 0, 0);  // Backslash
-
-    } else if (get_highest_layer(layer_state) == _BLUETOOTH) {
-        // Turn off all keys first
-        for (uint8_t i = led_min; i < led_max; i++) {
-            rgb_matrix_set_color(i, 0, 0, 0);
-        }
+    uint8_t indicators = rgb_power_indicator_level();
+    if (current_layer < ARRAY_SIZE(layer_led_tables)) {
+        rgb_frame_apply(frame, pgm_read_ptr(&layer_led_tables[current_layer].leds),
+                        pgm_read_byte(&layer_led_tables[current_layer].count), indicators);
+    }
+    if (lctrl_pressed || rctrl_pressed) {
+        rgb_frame_apply(frame, ctrl_leds, ARRAY_SIZE(ctrl_leds), indicators);
+    }
+    rgb_power_finish_frame(frame, RGB_MATRIX_LED_COUNT);
+    rgb_back_ready  = true;
+    rgb_frame_dirty = false;
+}
 
-        // Bluetooth pairing indicators in cyan (0x00FFFF)
-        rgb_matrix_set_color(15, 0, 255, 255);  // Q (Fn1+Q = BT device 1)
-        rgb_matrix_set_color(16, 0, 255, 255);  // W (Fn1+W = BT device 2)
-        rgb_matrix_set_color(17, 0, 255, 255);  // E (Fn1+E = BT device 3)
-        rgb_matrix_set_color(58, 0, 255, 255);  // Fn1 (Bluetooth/media/RGB control key)
+static uint16_t rgb_rebuild(void *arg) {
+    if (rgb_frame_dirty) {
+        rgb_frame_rebuild();
+        // A stopped RGB task never calls the indicator hook: this is how a key
+        // press or a layer change lights a dark keyboard up again.
+        rgb_power_update_rendering();
+    }
+    return SCHED_DONE;
+}
 
+static uint16_t rgb_fade(void *arg) {
+    uint8_t target = user_config.rgb_brightness;
+    if (rgb_brightness_shown < target) {
+        rgb_brightness_shown = target - rgb_brightness_shown > rgb_fade_step ? rgb_brightness_shown + rgb_fade_step : target;
     } else {
-        // Base layer: check if RGB is enabled
-        if (base_rgb_enabled) {
-            // Solid white at current brightness (RCtrl+[ / RCtrl+] to adjust)
-            for (uint8_t i = led_min; i < led_max; i++) {
-                rgb_matrix_set_color(i, rgb_brightness, rgb_brightness, rgb_brightness);
-            }
-        } else {
-            // RGB disabled - turn off all LEDs
-            for (uint8_t i = led_min; i < led_max; i++) {
-                rgb_matrix_set_color(i, 0, 0, 0);  // Off
-            }
-        }
+        rgb_brightness_shown = rgb_brightness_shown - target > rgb_fade_step ? rgb_brightness_shown - rgb_fade_step : target;
     }
+    rgb_frame_invalidate();
+    return rgb_brightness_shown == target ? SCHED_DONE : RGB_FADE_INTERVAL;
+}
 
-    // Visual indicator: ESC/Q/W/E/R in red when physical Ctrl is pressed (all layers)
-    // Shows available layer switching keys: Ctrl+Esc/Q/W/E/R
-    if (lctrl_pressed || rctrl_pressed) {
-        rgb_matrix_set_color(0, 255, 0, 0);   // ESC (Ctrl+Esc → Bluetooth)
-        rgb_matrix_set_color(15, 255, 0, 0);  // Q (Ctrl+Q → Base)
-        rgb_matrix_set_color(16, 255, 0, 0);  // W (Ctrl+W → Base)
-        rgb_matrix_set_color(17, 255, 0, 0);  // E (Ctrl+E → VIM)
-        rgb_matrix_set_color(18, 255, 0, 0);  // R (Ctrl+R → Numpad)
+// user_config.rgb_brightness changed: get there in RGB_FADE_TIME
+static void rgb_fade_start(void) {
+    uint8_t target   = user_config.rgb_brightness;
+    uint8_t distance = target > rgb_brightness_shown ? target - rgb_brightness_shown : rgb_brightness_shown - target;
+    rgb_fade_step    = MAX(1, distance * RGB_FADE_INTERVAL / RGB_FADE_TIME);
+    sched_wake(rgb_fade_task, 0);
+}
+
+// At boot, after user_config_init(); sched_init() has emptied the task table
+static void rgb_frame_init(void) {
+    rgb_rebuild_task     = sched_add(rgb_rebuild, NULL, SCHED_HIGH, 0, RGB_POWER_FLUSH_LIMIT);
+    rgb_fade_task        = sched_add(rgb_fade, NULL, SCHED_NORMAL, 0, RGB_FADE_INTERVAL);
+    rgb_brightness_shown = user_config.rgb_brightness;
+    rgb_frame_invalidate();
+}
+
+// After boot/wake, in a scan of its own before the RGB task starts again
+static void rgb_frame_prepare(void) {
+    rgb_power_task();
+    rgb_frame_rebuild();
+}
+
+static void rgb_housekeeping(void) {
+    if (rgb_power_task()) {
+        rgb_frame_invalidate();
     }
+    rgb_power_update_rendering();
+}
 
+// Called once per LED chunk: only the LEDs inside [led_min, led_max) are written.
+// A newly built frame is only taken at the first chunk.
+bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
+    if (rgb_back_ready && led_min == 0) {
+        rgb_front ^= 1;
+        rgb_back_ready = false;
+    }
+    uint8_t(*frame)[3] = rgb_frames[rgb_front];
+    for (uint8_t i = led_min; i < led_max; i++) {
+        rgb_matrix_set_color(i, frame[i][0], frame[i][1], frame[i][2]);
+    }
     return false;
 }
 #endif
-
@@ -0,0 +1,148 @@
+// Input latency tracer, see latency_trace.h.
+
+#include QMK_KEYBOARD_H
+#include <string.h>
+#include "dwt.h"
+#include "latency_trace.h"
+
+_Static_assert((LATENCY_TRACE_SIZE & (LATENCY_TRACE_SIZE - 1)) == 0, "LATENCY_TRACE_SIZE must be a power of two");
+
+// Single producer (the keyboard task), single consumer (raw HID, same task today).
+// `written` is published after the entry is complete, so a reader that checks it
+// before and after copying an entry knows whether the slot was overwritten.
+static latency_entry_t   ring[LATENCY_TRACE_SIZE];
+static volatile uint32_t written;
+static uint8_t           last_key = LT_KEY_NONE;
+static matrix_row_t      previous_matrix[MATRIX_ROWS];
+
+#if defined(__ARM_ARCH_7EM__)
+void latency_trace_init(void) {
+    dwt_init();
+}
+
+uint32_t latency_trace_clock(void) {
+    return dwt_cycles();
+}
+#else
+void latency_trace_init(void) {}
+
+// Microseconds at millisecond resolution; the host simulator overrides this
+// with its virtual microsecond clock.
+__attribute__((weak)) uint32_t latency_trace_clock(void) {
+    return timer_read32() * 1000u;
+}
+#endif
+
+void latency_trace_record(latency_stage_t stage, uint8_t key) {
+    if (stage == LT_PRU_EXIT) {
+        last_key = key;
+    } else if (stage == LT_REPORT) {
+        key = last_key;
+    }
+
+    uint32_t         seq   = written;
+    latency_entry_t *entry = &ring[seq & (LATENCY_TRACE_SIZE - 1)];
+    entry->time            = latency_trace_clock();
+    entry->stage           = stage;
+    entry->key             = key;
+    __atomic_store_n(&written, seq + 1, __ATOMIC_RELEASE);
+}
+
+// Called from matrix_scan_user: the matrix has just been debounced and the
+// changes have not been dispatched to the action layer yet.
+void latency_trace_matrix_scan(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        matrix_row_t current = matrix_get_row(row);
+        matrix_row_t changed = current ^ previous_matrix[row];
+        if (!changed) continue;
+        previous_matrix[row] = current;
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (changed & ((matrix_row_t)1 << col)) {
+                latency_trace_record(LT_MATRIX, LT_KEY(row, col));
+            }
+        }
+    }
+}
+
+void latency_trace_clear(void) {
+    __atomic_store_n(&written, 0, __ATOMIC_RELEASE);
+    last_key = LT_KEY_NONE;
+}
+
+uint32_t latency_trace_written(void) {
+    return __atomic_load_n(&written, __ATOMIC_ACQUIRE);
+}
+
+bool latency_trace_read(uint32_t seq, latency_entry_t *entry) {
+    uint32_t head = latency_trace_written();
+    // At head - LATENCY_TRACE_SIZE the producer may already be writing the slot
+    if (seq >= head || head - seq >= LATENCY_TRACE_SIZE) {
+        return false;
+    }
+    *entry = ring[seq & (LATENCY_TRACE_SIZE - 1)];
+    // Overwritten while copying?
+    return latency_trace_written() - seq < LATENCY_TRACE_SIZE;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, v & 0xFFFF);
+    put_u16(p + 2, v >> 16);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+bool latency_trace_raw_hid(uint8_t *data, uint8_t length) {
+    if (length < LATENCY_TRACE_PACKET_SIZE || data[0] != LATENCY_TRACE_RAW_HID_ID) {
+        return false;
+    }
+
+    uint8_t  cmd = data[1];
+    uint32_t arg = get_u32(data + 2);
+    memset(data + 2, 0, length - 2);
+    switch (cmd) {
+        case LT_CMD_INFO:
+            data[2] = LATENCY_TRACE_VERSION;
+            data[3] = LATENCY_TRACE_ENTRY_SIZE;
+            put_u16(data + 4, LATENCY_TRACE_SIZE);
+            put_u32(data + 6, latency_trace_written());
+            put_u32(data + 10, LATENCY_TRACE_CLOCK_HZ);
+            break;
+
+        case LT_CMD_READ: {
+            uint32_t seq   = arg;
+            uint8_t  count = 0;
+            // Skip forward past anything already overwritten
+            uint32_t head = latency_trace_written();
+            if (head >= LATENCY_TRACE_SIZE && seq <= head - LATENCY_TRACE_SIZE) {
+                seq = head - LATENCY_TRACE_SIZE + 1;
+            }
+            put_u32(data + 2, seq);
+            latency_entry_t entry;
+            while (count < LATENCY_TRACE_ENTRIES_PER_PACKET && latency_trace_read(seq + count, &entry)) {
+                uint8_t *p = data + 7 + count * LATENCY_TRACE_ENTRY_SIZE;
+                put_u32(p, entry.time);
+                p[4] = entry.stage;
+                p[5] = entry.key;
+                count++;
+            }
+            data[6] = count;
+            break;
+        }
+
+        case LT_CMD_CLEAR:
+            latency_trace_clear();
+            break;
+
+        default:
+            data[1] = 0xFF;  // unknown command
+            break;
+    }
+    return true;
+}
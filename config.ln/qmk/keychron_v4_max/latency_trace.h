@@ -0,0 +1,86 @@
+// Opt-in input latency tracing (LATENCY_TRACE_ENABLE = yes in rules.mk).
+//
+// Timestamps are written into a fixed-size ring at each stage a keystroke
+// passes through: matrix change, tap/hold resolution, process_record_user entry
+// and exit, HID report generated by QMK, and report handed to the transport
+// (later than generated when report_queue.h batches). The ring is a flight
+// recorder (oldest entries are overwritten) and is read out over raw HID by
+// host/latency_decode, which turns it into per-stage latency histograms.
+//
+// Raw HID protocol, 32-byte packets, byte 0 is always LATENCY_TRACE_RAW_HID_ID:
+//   request  [id, LT_CMD_INFO]
+//   response [id, LT_CMD_INFO, version, entry_size, capacity(u16), written(u32), clock_hz(u32)]
+//   request  [id, LT_CMD_READ, seq(u32)]
+//   response [id, LT_CMD_READ, seq(u32), count, count * entry]
+//   request  [id, LT_CMD_CLEAR]
+//   response [id, LT_CMD_CLEAR]
+// Multi-byte fields are little-endian. An entry is time(u32), stage(u8), key(u8),
+// key being row << 4 | col, or LT_KEY_NONE.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef LATENCY_TRACE_SIZE
+#    define LATENCY_TRACE_SIZE 256  // entries, power of two
+#endif
+#ifndef LATENCY_TRACE_CLOCK_HZ
+#    if defined(__ARM_ARCH_7EM__)
+#        define LATENCY_TRACE_CLOCK_HZ 80000000  // DWT cycle counter at the STM32L432 core clock
+#    else
+#        define LATENCY_TRACE_CLOCK_HZ 1000000
+#    endif
+#endif
+
+#define LATENCY_TRACE_VERSION 2
+#define LATENCY_TRACE_RAW_HID_ID 0x4C  // 'L'
+#define LATENCY_TRACE_PACKET_SIZE 32
+#define LATENCY_TRACE_ENTRY_SIZE 6
+#define LATENCY_TRACE_ENTRIES_PER_PACKET ((LATENCY_TRACE_PACKET_SIZE - 7) / LATENCY_TRACE_ENTRY_SIZE)
+
+enum latency_trace_cmd {
+    LT_CMD_INFO  = 0x01,
+    LT_CMD_READ  = 0x02,
+    LT_CMD_CLEAR = 0x03,
+};
+
+typedef enum {
+    LT_MATRIX,        // debounced matrix change seen by matrix_scan_user
+    LT_TAP_RESOLVED,  // tap/hold key decided (its press reaches process_record_user)
+    LT_PRU_ENTER,     // process_record_user entry
+    LT_PRU_EXIT,      // process_record_user exit
+    LT_REPORT,        // HID report generated (key: last processed key)
+    LT_SENT,          // queued reports handed to the transport
+    LT_STAGE_COUNT,
+} latency_stage_t;
+
+#define LT_KEY_NONE 0xFF
+#define LT_KEY(row, col) ((uint8_t)(((row) << 4) | ((col) & 0x0F)))
+
+typedef struct {
+    uint32_t time;
+    uint8_t  stage;
+    uint8_t  key;
+} latency_entry_t;
+
+#ifdef LATENCY_TRACE_ENABLE
+
+void     latency_trace_init(void);
+uint32_t latency_trace_clock(void);
+void     latency_trace_record(latency_stage_t stage, uint8_t key);
+void     latency_trace_matrix_scan(void);
+void     latency_trace_clear(void);
+
+// Total entries ever recorded; entry `seq` is readable while seq > written - LATENCY_TRACE_SIZE.
+uint32_t latency_trace_written(void);
+bool     latency_trace_read(uint32_t seq, latency_entry_t *entry);
+
+// Handles a raw HID request if it is addressed to the tracer; fills `data` with
+// the response in place. Returns false for packets that are not ours.
+bool latency_trace_raw_hid(uint8_t *data, uint8_t length);
+
+#    define LATENCY_TRACE(stage, key) latency_trace_record((stage), (key))
+#else
+#    define LATENCY_TRACE(stage, key) ((void)(key))
+#endif
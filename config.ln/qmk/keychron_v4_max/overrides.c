@@ -0,0 +1,88 @@
+// Key override engine, see overrides.h.
+
+#include <string.h>
+#include "overrides.h"
+
+typedef struct {
+    uint16_t trigger;  // KC_NO: free
+    uint8_t  replacement;
+    uint8_t  restore_mods;  // suppressed mods to put back on release
+} active_override_t;
+
+static active_override_t active[OVERRIDE_MAX_ACTIVE];
+
+static bool rule_matches(const override_rule_t *rule, uint8_t layer, bool ctrl_held) {
+    if (layer >= 8 || !(pgm_read_byte(&rule->layers) & (1u << layer))) {
+        return false;
+    }
+    switch (pgm_read_byte(&rule->ctrl)) {
+        case OVERRIDE_CTRL_UP:
+            if (ctrl_held) return false;
+            break;
+        case OVERRIDE_CTRL_HELD:
+            if (!ctrl_held) return false;
+            break;
+    }
+    uint8_t required = pgm_read_byte(&rule->required_mods);
+    return !required || (get_mods() & required);
+}
+
+static bool start_override(const override_rule_t *rule, uint16_t keycode) {
+    active_override_t *slot = NULL;
+    for (uint8_t i = 0; i < OVERRIDE_MAX_ACTIVE; i++) {
+        if (active[i].trigger == KC_NO) {
+            slot = &active[i];
+            break;
+        }
+    }
+    if (!slot) {
+        return false;  // too many held at once: fall back to the plain key
+    }
+
+    // New mods and the replacement key go out together in one report
+    slot->trigger      = keycode;
+    slot->replacement  = pgm_read_byte(&rule->replacement);
+    slot->restore_mods = get_mods() & pgm_read_byte(&rule->suppressed_mods);
+    del_mods(slot->restore_mods);
+    add_key(slot->replacement);
+    send_keyboard_report();
+    return true;
+}
+
+static bool end_override(uint16_t keycode) {
+    for (uint8_t i = 0; i < OVERRIDE_MAX_ACTIVE; i++) {
+        if (active[i].trigger == keycode) {
+            del_key(active[i].replacement);
+            add_mods(active[i].restore_mods);
+            send_keyboard_report();
+            active[i].trigger = KC_NO;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool process_overrides(uint16_t keycode, keyrecord_t *record, uint8_t layer, bool ctrl_held) {
+    if (!record->event.pressed) {
+        if (IS_MODIFIER_KEYCODE(keycode)) {
+            // A suppressed modifier let go meanwhile must not come back
+            for (uint8_t i = 0; i < OVERRIDE_MAX_ACTIVE; i++) {
+                active[i].restore_mods &= ~MOD_BIT(keycode);
+            }
+            return true;
+        }
+        return !end_override(keycode);
+    }
+
+    for (uint8_t i = 0; i < override_rule_count; i++) {
+        const override_rule_t *rule = &override_rules[i];
+        if (pgm_read_word(&rule->trigger) == keycode && rule_matches(rule, layer, ctrl_held)) {
+            return !start_override(rule, keycode);
+        }
+    }
+    return true;
+}
+
+void overrides_reset(void) {
+    memset(active, 0, sizeof(active));
+}
@@ -0,0 +1,39 @@
+// Key overrides: rewrite a trigger key into a replacement keycode and modifier
+// set inside a single HID report, instead of del_mods/tap_code/set_mods sequences
+// that cost several reports (and radio packets) per keystroke.
+//
+// The keymap owns the rule table (override_rules[], PROGMEM) and calls
+// process_overrides() first thing from process_record_user.
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifndef OVERRIDE_MAX_ACTIVE
+#    define OVERRIDE_MAX_ACTIVE 4  // overridden keys held at the same time
+#endif
+
+// Condition on the keymap's physical Ctrl state (Right Ctrl never reaches the mods)
+enum override_ctrl {
+    OVERRIDE_CTRL_ANY,
+    OVERRIDE_CTRL_UP,
+    OVERRIDE_CTRL_HELD,
+};
+
+typedef struct {
+    uint8_t  layers;           // bit per layer (highest active layer) the rule applies on
+    uint16_t trigger;          // keycode the key resolves to
+    uint8_t  ctrl;             // enum override_ctrl
+    uint8_t  required_mods;    // at least one of these must be held (0: none needed)
+    uint8_t  suppressed_mods;  // taken out of the report while the override is down
+    uint8_t  replacement;      // basic keycode sent instead of the trigger
+} override_rule_t;
+
+extern const override_rule_t override_rules[];
+extern const uint8_t         override_rule_count;
+
+// Returns false when the event was consumed by an override (press or release).
+bool process_overrides(uint16_t keycode, keyrecord_t *record, uint8_t layer, bool ctrl_held);
+
+// Drops all active overrides without touching the report (tests, resets).
+void overrides_reset(void);
@@ -0,0 +1,164 @@
+// Report coalescing queue, see report_queue.h.
+
+#include <string.h>
+#include "report_queue.h"
+
+typedef enum {
+    RQ_KEYBOARD,
+    RQ_NKRO,
+    RQ_SYSTEM,  // extra reports: the host keeps one state per report id
+    RQ_CONSUMER,
+    RQ_KIND_COUNT,
+} rq_kind_t;
+
+typedef struct {
+    uint8_t kind;
+    union {
+        report_keyboard_t keyboard;
+        report_nkro_t     nkro;
+        report_extra_t    extra;
+    };
+} rq_entry_t;
+
+static rq_entry_t           queue[REPORT_QUEUE_SIZE];
+static uint8_t              queued;
+static rq_entry_t           last_sent[RQ_KIND_COUNT];  // what the host has, per report kind
+static bool                 have_sent[RQ_KIND_COUNT];
+static report_queue_stats_t stats;
+
+__attribute__((weak)) bool report_queue_batching(void) {
+    return true;
+}
+
+static bool same_report(const rq_entry_t *a, const rq_entry_t *b) {
+    switch (a->kind) {
+        case RQ_KEYBOARD:
+            return memcmp(&a->keyboard, &b->keyboard, sizeof(a->keyboard)) == 0;
+        case RQ_NKRO:
+            return memcmp(&a->nkro, &b->nkro, sizeof(a->nkro)) == 0;
+        default:
+            return a->extra.report_id == b->extra.report_id && a->extra.usage == b->extra.usage;
+    }
+}
+
+// Report state as one bit per modifier and key, so edges are plain XORs.
+typedef struct {
+    uint8_t bytes[1 + 32];
+} key_bits_t;
+
+static void to_bits(const rq_entry_t *entry, key_bits_t *bits) {
+    memset(bits, 0, sizeof(*bits));
+    if (entry->kind == RQ_NKRO) {
+        bits->bytes[0] = entry->nkro.mods;
+        memcpy(bits->bytes + 1, entry->nkro.bits, MIN(sizeof(entry->nkro.bits), sizeof(bits->bytes) - 1));
+    } else {
+        bits->bytes[0] = entry->keyboard.mods;
+        for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; i++) {
+            uint8_t code = entry->keyboard.keys[i];
+            if (code) bits->bytes[1 + (code >> 3)] |= 1 << (code & 7);
+        }
+    }
+}
+
+// `next` may replace `tail` if nothing `tail` changed relative to `before` is
+// changed back by `next`: the host then never misses a press or release.
+static bool can_merge(const rq_entry_t *before, const rq_entry_t *tail, const rq_entry_t *next) {
+    if (tail->kind == RQ_SYSTEM || tail->kind == RQ_CONSUMER) {
+        return false;  // extra reports carry a single usage; any change is an edge
+    }
+    key_bits_t s, q, n;
+    to_bits(before, &s);
+    to_bits(tail, &q);
+    to_bits(next, &n);
+    for (uint8_t i = 0; i < sizeof(s.bytes); i++) {
+        if ((s.bytes[i] ^ q.bytes[i]) & (q.bytes[i] ^ n.bytes[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The newest report of `kind` before queue position `end` (or the host's copy)
+static const rq_entry_t *latest(uint8_t kind, uint8_t end) {
+    for (uint8_t i = end; i-- > 0;) {
+        if (queue[i].kind == kind) return &queue[i];
+    }
+    return have_sent[kind] ? &last_sent[kind] : NULL;
+}
+
+static void send(const rq_entry_t *entry, host_driver_t *out) {
+    last_sent[entry->kind] = *entry;
+    have_sent[entry->kind] = true;
+    stats.sent++;
+    switch (entry->kind) {
+        case RQ_KEYBOARD:
+            out->send_keyboard((report_keyboard_t *)&entry->keyboard);
+            break;
+        case RQ_NKRO:
+            out->send_nkro((report_nkro_t *)&entry->nkro);
+            break;
+        default:
+            out->send_extra((report_extra_t *)&entry->extra);
+            break;
+    }
+}
+
+static void enqueue(const rq_entry_t *entry, host_driver_t *out) {
+    stats.generated++;
+
+    const rq_entry_t *current = latest(entry->kind, queued);
+    if (current && same_report(current, entry)) {
+        stats.dropped++;
+        return;
+    }
+
+    if (queued && queue[queued - 1].kind == entry->kind) {
+        rq_entry_t       *tail   = &queue[queued - 1];
+        rq_entry_t        empty  = {.kind = entry->kind};  // nothing sent yet: host has no keys down
+        const rq_entry_t *before = latest(entry->kind, queued - 1);
+        if (can_merge(before ? before : &empty, tail, entry)) {
+            *tail = *entry;
+            stats.merged++;
+            return;
+        }
+    }
+
+    if (queued == REPORT_QUEUE_SIZE) {
+        send(&queue[0], out);
+        memmove(queue, queue + 1, sizeof(queue[0]) * (REPORT_QUEUE_SIZE - 1));
+        queued--;
+    }
+    queue[queued++] = *entry;
+}
+
+void report_queue_keyboard(report_keyboard_t *report, host_driver_t *out) {
+    rq_entry_t entry = {.kind = RQ_KEYBOARD, .keyboard = *report};
+    enqueue(&entry, out);
+}
+
+void report_queue_nkro(report_nkro_t *report, host_driver_t *out) {
+    rq_entry_t entry = {.kind = RQ_NKRO, .nkro = *report};
+    enqueue(&entry, out);
+}
+
+void report_queue_extra(report_extra_t *report, host_driver_t *out) {
+    rq_entry_t entry = {.kind = report->report_id == REPORT_ID_SYSTEM ? RQ_SYSTEM : RQ_CONSUMER, .extra = *report};
+    enqueue(&entry, out);
+}
+
+void report_queue_flush(host_driver_t *out) {
+    for (uint8_t i = 0; i < queued; i++) {
+        send(&queue[i], out);
+    }
+    queued = 0;
+}
+
+const report_queue_stats_t *report_queue_stats(void) {
+    return &stats;
+}
+
+void report_queue_reset(void) {
+    queued = 0;
+    memset(have_sent, 0, sizeof(have_sent));
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,33 @@
+// Report coalescing queue (REPORT_QUEUE_ENABLE = yes in rules.mk).
+//
+// Sits in host_shim between QMK and the transport. Reports produced during one
+// scan are held and flushed from housekeeping; on the way a report that only
+// extends the one queued before it (no key or modifier goes back the way it
+// came) replaces it, and reports identical to what the host already has are
+// dropped. A tap (down then up in the same scan) is never merged away.
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifndef REPORT_QUEUE_SIZE
+#    define REPORT_QUEUE_SIZE 8  // reports held per scan before the oldest is sent early
+#endif
+
+typedef struct {
+    uint32_t generated;  // reports handed over by QMK
+    uint32_t sent;       // reports passed on to the transport
+    uint32_t merged;     // replaced by a later report in the same scan
+    uint32_t dropped;    // identical to what the host already had
+} report_queue_stats_t;
+
+// Whether to batch right now. Weak; the keymap batches on wireless only.
+bool report_queue_batching(void);
+
+void report_queue_keyboard(report_keyboard_t *report, host_driver_t *out);
+void report_queue_nkro(report_nkro_t *report, host_driver_t *out);
+void report_queue_extra(report_extra_t *report, host_driver_t *out);
+void report_queue_flush(host_driver_t *out);
+
+const report_queue_stats_t *report_queue_stats(void);
+void                        report_queue_reset(void);
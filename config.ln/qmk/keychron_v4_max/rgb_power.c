@@ -0,0 +1,90 @@
+// RGB power management, see rgb_power.h.
+
+#include "rgb_power.h"
+
+uint8_t rgb_power_flush_limit = RGB_POWER_FLUSH_LIMIT;
+
+static uint32_t last_activity;
+static uint8_t  idle_level = 255;
+static bool     on_battery;
+static bool     frame_lit = true;
+static bool     stopped_by_us;  // the RGB task is off because the frame went dark
+
+__attribute__((weak)) bool rgb_power_on_battery(void) {
+    return false;
+}
+
+void rgb_power_activity(void) {
+    last_activity = timer_read32();
+}
+
+bool rgb_power_task(void) {
+    uint32_t idle    = timer_elapsed32(last_activity);
+    uint8_t  level   = idle >= RGB_POWER_OFF_TIMEOUT ? 0 : idle >= RGB_POWER_DIM_TIMEOUT ? RGB_POWER_DIM_LEVEL : 255;
+    bool     battery = rgb_power_on_battery();
+
+    bool changed          = level != idle_level || battery != on_battery;
+    idle_level            = level;
+    on_battery            = battery;
+    rgb_power_flush_limit = on_battery ? RGB_POWER_BATTERY_FLUSH_LIMIT : RGB_POWER_FLUSH_LIMIT;
+    return changed;
+}
+
+void rgb_power_update_rendering(void) {
+    if (!frame_lit && rgb_matrix_is_enabled()) {
+        rgb_matrix_disable_noeeprom();
+        stopped_by_us = true;
+    } else if (frame_lit && stopped_by_us) {
+        rgb_matrix_enable_noeeprom();
+        stopped_by_us = false;
+    }
+}
+
+uint8_t rgb_power_fill_level(void) {
+    return idle_level;
+}
+
+uint8_t rgb_power_indicator_level(void) {
+    if (on_battery) {
+        return RGB_POWER_INDICATOR_LEVEL;
+    }
+    return MAX(idle_level, RGB_POWER_INDICATOR_LEVEL);
+}
+
+uint8_t rgb_power_gamma(uint8_t value) {
+    return (uint8_t)(((uint16_t)value * value + 254) / 255);
+}
+
+uint8_t rgb_power_scale(uint8_t value, uint8_t level) {
+    return (uint8_t)(((uint16_t)value * (level + 1)) >> 8);
+}
+
+void rgb_power_finish_frame(uint8_t frame[][3], uint8_t count) {
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        sum += frame[i][0] + frame[i][1] + frame[i][2];
+    }
+    frame_lit = sum > 0;
+
+    // Current in units of RGB_POWER_CHANNEL_MA / 255
+    uint32_t budget = (uint32_t)(on_battery ? RGB_POWER_BATTERY_BUDGET_MA : RGB_POWER_BUDGET_MA) * 255;
+    uint32_t draw   = sum * RGB_POWER_CHANNEL_MA;
+    if (draw <= budget) {
+        return;
+    }
+    uint16_t scale = (uint16_t)((budget << 8) / draw);  // 8.8 fixed point, < 1.0
+    for (uint8_t i = 0; i < count; i++) {
+        for (uint8_t c = 0; c < 3; c++) {
+            frame[i][c] = (uint8_t)((frame[i][c] * scale) >> 8);
+        }
+    }
+}
+
+void rgb_power_reset(void) {
+    last_activity         = timer_read32();
+    idle_level            = 255;
+    on_battery            = false;
+    frame_lit             = true;
+    stopped_by_us         = false;
+    rgb_power_flush_limit = RGB_POWER_FLUSH_LIMIT;
+}
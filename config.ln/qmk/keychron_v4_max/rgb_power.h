@@ -0,0 +1,71 @@
+// RGB power management for the indicator frame built in keymap.c.
+//
+// - Gamma: the manual brightness steps are perceptual (x^2), not linear PWM.
+// - Current budget: a frame drawing more than the budget is scaled down as a whole.
+// - Idle: after RGB_POWER_DIM_TIMEOUT the frame dims, after RGB_POWER_OFF_TIMEOUT
+//   the base fill goes dark. Layer indicators stay at RGB_POWER_INDICATOR_LEVEL.
+//   A dark frame stops the RGB task until something lights up again.
+// - Battery: smaller budget, indicators only at their floor level, and a slower
+//   refresh (RGB_MATRIX_LED_FLUSH_LIMIT is rgb_power_flush_limit, see config.h).
+//
+// All of it is applied when the frame is rebuilt, never per RGB tick.
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifndef RGB_POWER_CHANNEL_MA
+#    define RGB_POWER_CHANNEL_MA 4  // one LED color channel at full PWM (estimate)
+#endif
+#ifndef RGB_POWER_BUDGET_MA
+#    define RGB_POWER_BUDGET_MA 500  // all LEDs together, on USB
+#endif
+#ifndef RGB_POWER_BATTERY_BUDGET_MA
+#    define RGB_POWER_BATTERY_BUDGET_MA 150
+#endif
+#ifndef RGB_POWER_DIM_TIMEOUT
+#    define RGB_POWER_DIM_TIMEOUT 30000  // ms without a key press
+#endif
+#ifndef RGB_POWER_OFF_TIMEOUT
+#    define RGB_POWER_OFF_TIMEOUT 120000
+#endif
+#ifndef RGB_POWER_DIM_LEVEL
+#    define RGB_POWER_DIM_LEVEL 64  // of 255
+#endif
+#ifndef RGB_POWER_INDICATOR_LEVEL
+#    define RGB_POWER_INDICATOR_LEVEL 96  // layer indicators never go below this while lit
+#endif
+#ifndef RGB_POWER_FLUSH_LIMIT
+#    define RGB_POWER_FLUSH_LIMIT 16  // ms per frame on USB (QMK default)
+#endif
+#ifndef RGB_POWER_BATTERY_FLUSH_LIMIT
+#    define RGB_POWER_BATTERY_FLUSH_LIMIT 50
+#endif
+
+extern uint8_t rgb_power_flush_limit;
+
+// Whether the keyboard runs from its battery. Weak; false unless the keymap says otherwise.
+bool rgb_power_on_battery(void);
+
+// A key was pressed: back to full brightness.
+void rgb_power_activity(void);
+
+// From housekeeping. Returns true when the brightness level or the battery
+// state changed, i.e. the frame must be rebuilt.
+bool rgb_power_task(void);
+
+// Starts or stops the RGB task to match the last finished frame. Only undoes
+// its own stops, never a user's RGB toggle.
+void rgb_power_update_rendering(void);
+
+// Scale for the base fill and for indicators, 0-255.
+uint8_t rgb_power_fill_level(void);
+uint8_t rgb_power_indicator_level(void);
+
+uint8_t rgb_power_gamma(uint8_t value);
+uint8_t rgb_power_scale(uint8_t value, uint8_t level);
+
+// Caps the frame at the current budget and remembers whether anything is lit.
+void rgb_power_finish_frame(uint8_t frame[][3], uint8_t count);
+
+void rgb_power_reset(void);
@@ -13,3 +13,32 @@ AUDIO_ENABLE = no           # Audio output
 
 # Reduce firmware size
 LTO_ENABLE = no             # Must be disabled for V4 Max wireless code compatibility
+
+# Per-function stack frames (.su next to each object) for host/footprint
+EXTRAFLAGS += -fstack-usage
+
+# Keymap sources
+SRC += adaptive_tapping.c fast_wake.c host_shim.c overrides.c sched.c typing_streak.c user_config.c
+ifeq ($(strip $(RGB_MATRIX_ENABLE)), yes)
+    SRC += rgb_power.c
+endif
+
+# Eager-press, deferred-release debounce with per-key chatter detection (debounce_asym.h)
+DEBOUNCE_TYPE = custom
+SRC += debounce_asym.c
+
+# Input latency tracing over raw HID, read out with host/latency_decode.
+# Off by default; build with `make ... LATENCY_TRACE_ENABLE=yes` to turn it on.
+LATENCY_TRACE_ENABLE ?= no
+ifeq ($(strip $(LATENCY_TRACE_ENABLE)), yes)
+    RAW_ENABLE = yes
+    OPT_DEFS += -DLATENCY_TRACE_ENABLE
+    SRC += latency_trace.c
+endif
+
+# Per-scan HID report coalescing for the wireless transports (report_queue.h).
+REPORT_QUEUE_ENABLE ?= yes
+ifeq ($(strip $(REPORT_QUEUE_ENABLE)), yes)
+    OPT_DEFS += -DREPORT_QUEUE_ENABLE
+    SRC += report_queue.c
+endif
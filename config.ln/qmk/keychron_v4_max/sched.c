@@ -0,0 +1,176 @@
+// Cooperative background scheduler, see sched.h.
+
+#include <string.h>
+#include "dwt.h"
+#include "sched.h"
+
+typedef struct {
+    sched_fn_t    fn;
+    void         *arg;
+    uint32_t      due;  // timer_read32() ms
+    uint32_t      last_scan;  // one step per task per scan
+    uint16_t      period;
+    uint16_t      deadline;
+    uint8_t       priority;
+    bool          armed;
+    bool          running;  // mid-job: the steps after the first are not new jobs
+    sched_stats_t stats;
+} task_t;
+
+static task_t       tasks[SCHED_MAX_TASKS];
+static uint8_t      task_count;
+static uint32_t     scan;
+static bool         key_seen;  // key event since the last sched_task()
+static sched_load_t window, load;
+
+#if defined(__ARM_ARCH_7EM__)
+static void clock_init(void) {
+    dwt_init();
+}
+
+uint32_t sched_clock(void) {
+    return dwt_cycles();
+}
+#else
+static void clock_init(void) {}
+
+// Millisecond resolution: without a real microsecond clock every step fits the budget
+__attribute__((weak)) uint32_t sched_clock(void) {
+    return timer_read32() * 1000u;
+}
+#endif
+
+// Microseconds since `start`; the tick difference is taken first, so it survives a wrap
+static uint32_t elapsed_us(uint32_t start) {
+    return (sched_clock() - start) / SCHED_CLOCK_MHZ;
+}
+
+static bool reached(uint32_t now, uint32_t time) {
+    return (int32_t)(now - time) >= 0;
+}
+
+static uint16_t load_task(void *arg) {
+    load   = window;
+    window = (sched_load_t){0};
+    return SCHED_DONE;
+}
+
+void sched_init(void) {
+    memset(tasks, 0, sizeof(tasks));
+    task_count = 0;
+    key_seen   = false;
+    window = load = (sched_load_t){0};
+    clock_init();
+    sched_add(load_task, NULL, SCHED_LOW, SCHED_LOAD_PERIOD, SCHED_LOAD_PERIOD);
+}
+
+uint8_t sched_add(sched_fn_t fn, void *arg, sched_priority_t priority, uint16_t period, uint16_t deadline) {
+    if (task_count == SCHED_MAX_TASKS) {
+        return SCHED_NONE;
+    }
+    task_t *t   = &tasks[task_count];
+    t->fn       = fn;
+    t->arg      = arg;
+    t->priority = priority;
+    t->period   = period;
+    t->deadline = deadline;
+    t->armed    = period != 0;
+    t->due      = timer_read32() + period;
+    return task_count++;
+}
+
+void sched_wake(uint8_t id, uint16_t delay) {
+    if (id >= task_count) {
+        return;
+    }
+    task_t  *t   = &tasks[id];
+    uint32_t due = timer_read32() + delay;
+    if (!t->armed || reached(t->due, due)) {
+        t->due   = due;
+        t->armed = true;
+    }
+}
+
+void sched_key_event(void) {
+    key_seen = true;
+}
+
+static task_t *next_due(uint32_t now) {
+    task_t *best = NULL;
+    for (uint8_t i = 0; i < task_count; i++) {
+        task_t *t = &tasks[i];
+        if (!t->armed || t->last_scan == scan || !reached(now, t->due)) {
+            continue;
+        }
+        if (!best || t->priority < best->priority || (t->priority == best->priority && !reached(t->due, best->due))) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+static void run(task_t *t, uint32_t now, uint32_t budget_left) {
+    uint32_t due = t->due;
+    if (!t->running) {
+        uint32_t late = now - due;
+        t->stats.jobs++;
+        t->stats.latency_total += late;
+        if (late > t->stats.latency_max) t->stats.latency_max = late > UINT16_MAX ? UINT16_MAX : (uint16_t)late;
+        if (late > t->deadline) t->stats.missed++;
+    }
+    t->last_scan = scan;
+    t->armed     = false;  // a task may sched_wake() itself from inside the step
+
+    uint32_t start = sched_clock();
+    uint16_t next  = t->fn(t->arg);
+    uint32_t took  = elapsed_us(start);
+
+    t->stats.steps++;
+    if (took > t->stats.step_us_max) t->stats.step_us_max = took;
+    if (took > budget_left) t->stats.overruns++;
+
+    if (next != SCHED_DONE) {
+        t->running = true;
+        t->armed   = true;
+        t->due     = now + next;
+        return;
+    }
+    t->running = false;
+    if (t->period && !t->armed) {
+        // Keeps its phase; a task that fell a whole period behind skips rather than bursts
+        t->armed = true;
+        t->due   = reached(now, due + t->period) ? now + t->period : due + t->period;
+    }
+}
+
+void sched_task(void) {
+    scan++;
+    window.scans++;
+    if (key_seen) {
+        key_seen = false;
+        window.key_scans++;
+        return;
+    }
+
+    uint32_t now   = timer_read32();
+    uint32_t start = sched_clock();
+    uint32_t used  = 0;
+    task_t  *t;
+    for (bool first = true; (t = next_due(now)) != NULL; first = false) {
+        if (!first && used >= SCHED_SCAN_BUDGET_US) {
+            break;
+        }
+        run(t, now, SCHED_SCAN_BUDGET_US > used ? SCHED_SCAN_BUDGET_US - used : 0);
+        used = elapsed_us(start);
+    }
+    window.busy_us += used;
+}
+
+const sched_stats_t *sched_stats(uint8_t id) {
+    static const sched_stats_t none;
+    return id < task_count ? &tasks[id].stats : &none;
+}
+
+const sched_load_t *sched_load(void) {
+    return &load;
+}
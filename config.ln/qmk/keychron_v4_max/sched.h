@@ -0,0 +1,89 @@
+// Cooperative scheduler for the keymap's background work.
+//
+// - Tasks: a fixed table of SCHED_MAX_TASKS functions, each with a priority, an
+//   optional period and a deadline. A task does one short step per call and
+//   returns when it wants the next one: SCHED_DONE (job finished: sleep until the
+//   period comes round or sched_wake()), 0 (next scan) or a delay in ms.
+// - Budget: sched_task() runs from housekeeping_task_user(), after the scan's key
+//   events. Due tasks run highest priority first, the longest waiting first within
+//   a priority, until SCHED_SCAN_BUDGET_US is spent; the rest wait for the next
+//   scan. The first step of a scan always runs, so no task starves.
+// - Keys first: in a scan that handled a key event, no background work runs.
+// - Stats per task: steps, overruns (a step that ran past the scan's budget),
+//   deadline misses (a job that started more than its deadline after it became
+//   due), and the time from due to start.
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifndef SCHED_MAX_TASKS
+#    define SCHED_MAX_TASKS 8
+#endif
+#ifndef SCHED_SCAN_BUDGET_US
+#    define SCHED_SCAN_BUDGET_US 250  // background work per scan
+#endif
+#ifndef SCHED_CLOCK_MHZ
+#    if defined(__ARM_ARCH_7EM__)
+#        define SCHED_CLOCK_MHZ 80  // DWT cycle counter at the STM32L432 core clock
+#    else
+#        define SCHED_CLOCK_MHZ 1
+#    endif
+#endif
+#ifndef SCHED_LOAD_PERIOD
+#    define SCHED_LOAD_PERIOD 1000  // ms per sched_load() window
+#endif
+
+#define SCHED_DONE UINT16_MAX
+#define SCHED_NONE 0xFF
+
+typedef enum {
+    SCHED_HIGH,
+    SCHED_NORMAL,
+    SCHED_LOW,
+} sched_priority_t;
+
+// One step of work. Returns SCHED_DONE, 0 or the ms until the next step.
+typedef uint16_t (*sched_fn_t)(void *arg);
+
+typedef struct {
+    uint32_t steps;
+    uint32_t jobs;           // first steps: wake-ups and periods that came round
+    uint16_t overruns;       // steps that went past the scan's budget
+    uint16_t missed;         // jobs started later than the deadline
+    uint16_t latency_max;    // ms from due to the job's first step
+    uint32_t latency_total;  // ms, over `jobs`
+    uint32_t step_us_max;
+} sched_stats_t;
+
+// Background load over the last complete SCHED_LOAD_PERIOD window, collected
+// by the scheduler's own SCHED_LOW task.
+typedef struct {
+    uint16_t scans;
+    uint16_t key_scans;  // scans that skipped background work for a key event
+    uint32_t busy_us;    // spent in tasks
+} sched_load_t;
+
+// Free-running ticks, SCHED_CLOCK_MHZ per microsecond: the DWT cycle counter on
+// the Cortex-M4 (dwt.h); weak microseconds elsewhere, the host simulator
+// overrides it with its virtual clock.
+uint32_t sched_clock(void);
+
+// Empties the table and registers the load task. Call before sched_add().
+void sched_init(void);
+
+// `period` 0: runs only after sched_wake(). Otherwise first due one period from
+// now. Returns the task id, or SCHED_NONE when the table is full.
+uint8_t sched_add(sched_fn_t fn, void *arg, sched_priority_t priority, uint16_t period, uint16_t deadline);
+
+// Due in `delay` ms, or sooner if it already was. Cheap enough for key handlers.
+void sched_wake(uint8_t id, uint16_t delay);
+
+// From pre_process_record_user: this scan belongs to the keys.
+void sched_key_event(void);
+
+// From housekeeping_task_user.
+void sched_task(void);
+
+const sched_stats_t *sched_stats(uint8_t id);
+const sched_load_t  *sched_load(void);
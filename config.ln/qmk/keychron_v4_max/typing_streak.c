@@ -0,0 +1,44 @@
+// Typing-streak detector, see typing_streak.h.
+
+#include "typing_streak.h"
+
+_Static_assert(TYPING_STREAK_KEYS >= 2, "a streak needs at least one interval");
+
+static uint16_t presses[TYPING_STREAK_KEYS];  // ring of press times
+static uint8_t  newest;
+static uint8_t  count;
+
+static bool is_typing_key(uint16_t keycode) {
+    return keycode >= KC_A && keycode <= KC_SLSH;
+}
+
+void typing_streak_press(uint16_t keycode, uint8_t mods, uint16_t time) {
+    if (IS_MODIFIER_KEYCODE(keycode) || IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode)) {
+        return;  // neutral: a dual-role key still being arbitrated, or Shift for a capital
+    }
+    if (!is_typing_key(keycode) || (mods & ~MOD_MASK_SHIFT)) {
+        count = 0;
+        return;
+    }
+    if (count && TIMER_DIFF_16(time, presses[newest]) >= TYPING_STREAK_QUIET) {
+        count = 0;
+    }
+    newest          = (newest + 1) % TYPING_STREAK_KEYS;
+    presses[newest] = time;
+    if (count < TYPING_STREAK_KEYS) {
+        count++;
+    }
+}
+
+bool typing_streak_active(uint16_t time) {
+    if (count < TYPING_STREAK_KEYS || TIMER_DIFF_16(time, presses[newest]) >= TYPING_STREAK_QUIET) {
+        return false;
+    }
+    uint16_t oldest = presses[(newest + 1) % TYPING_STREAK_KEYS];
+    return TIMER_DIFF_16(presses[newest], oldest) <= (TYPING_STREAK_KEYS - 1) * TYPING_STREAK_INTERVAL;
+}
+
+void typing_streak_reset(void) {
+    count  = 0;
+    newest = 0;
+}
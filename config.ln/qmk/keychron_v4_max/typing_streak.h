@@ -0,0 +1,34 @@
+// Typing-streak detector for the dual-role keys.
+//
+// Keeps the press times of the last TYPING_STREAK_KEYS typing keys (letters,
+// digits, punctuation, space and the tap side of Esc/Enter/`). A streak is on
+// while those presses average no more than TYPING_STREAK_INTERVAL ms apart and
+// the newest is less than TYPING_STREAK_QUIET ms old. Any other key (arrows,
+// F-keys, layer keys) or a typing key with Ctrl/Alt/GUI held ends it; Shift and
+// modifier keys by themselves do not count either way.
+//
+// The keymap uses it to resolve Esc/Ctrl, Enter/Ctrl and `/VIM as taps on press
+// during prose, where a Ctrl chord is never what was meant.
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifndef TYPING_STREAK_KEYS
+#    define TYPING_STREAK_KEYS 4  // presses in the sliding window
+#endif
+#ifndef TYPING_STREAK_INTERVAL
+#    define TYPING_STREAK_INTERVAL 200  // ms, average gap in the window
+#endif
+#ifndef TYPING_STREAK_QUIET
+#    define TYPING_STREAK_QUIET 250  // ms without a typing key that ends a streak
+#endif
+
+// Every key press, before tap/hold arbitration. `keycode` is what the key
+// resolves to (the tap keycode for a dual-role key resolved by the streak).
+void typing_streak_press(uint16_t keycode, uint8_t mods, uint16_t time);
+
+// Whether a press at `time` is part of a streak.
+bool typing_streak_active(uint16_t time);
+
+void typing_streak_reset(void);
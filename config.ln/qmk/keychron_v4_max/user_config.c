@@ -0,0 +1,124 @@
+// Persisted keymap settings, see user_config.h.
+
+#include <stddef.h>
+#include <string.h>
+#include "user_config.h"
+
+typedef struct {
+    uint16_t      seq;      // newest record wins (wrapping compare)
+    uint8_t       version;  // USER_CONFIG_VERSION
+    uint8_t       crc;      // CRC-8 over the rest of the record
+    user_config_t config;
+    uint8_t       reserved[USER_CONFIG_RECORD_SIZE - 4 - sizeof(user_config_t)];
+} user_config_record_t;
+
+_Static_assert(sizeof(user_config_record_t) == USER_CONFIG_RECORD_SIZE, "user_config_t outgrew the record");
+_Static_assert(USER_CONFIG_SLOTS * USER_CONFIG_RECORD_SIZE <= EECONFIG_USER_DATA_SIZE, "EECONFIG_USER_DATA_SIZE too small");
+
+static const user_config_t defaults = {
+    .base_rgb_enabled = true,
+    .rgb_brightness   = 255,
+};
+
+user_config_t user_config = {
+    .base_rgb_enabled = true,
+    .rgb_brightness   = 255,
+};
+
+static user_config_t stored;      // what the newest record holds
+static uint16_t      stored_seq;
+static uint8_t       stored_slot = USER_CONFIG_SLOTS - 1;  // first save goes to slot 0
+static bool          pending;
+static uint32_t      last_event;
+static uint32_t      writes;
+
+static uint8_t *slot_address(uint8_t slot) {
+    return (uint8_t *)EECONFIG_USER_DATABLOCK + slot * USER_CONFIG_RECORD_SIZE;
+}
+
+// CRC-8, polynomial 0x07, over everything but the crc byte
+static uint8_t record_crc(const user_config_record_t *record) {
+    const uint8_t *bytes = (const uint8_t *)record;
+    uint8_t        crc   = 0xFF;
+    for (uint8_t i = 0; i < sizeof(*record); i++) {
+        if (i == offsetof(user_config_record_t, crc)) {
+            continue;
+        }
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)(crc << 1) ^ 0x07 : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool user_config_init(void) {
+    bool found = false;
+    for (uint8_t slot = 0; slot < USER_CONFIG_SLOTS; slot++) {
+        user_config_record_t record;
+        eeprom_read_block(&record, slot_address(slot), sizeof(record));
+        if (record.version != USER_CONFIG_VERSION || record.crc != record_crc(&record)) {
+            continue;
+        }
+        if (!found || (int16_t)(record.seq - stored_seq) > 0) {
+            found       = true;
+            stored      = record.config;
+            stored_seq  = record.seq;
+            stored_slot = slot;
+        }
+    }
+    if (!found) {
+        stored      = defaults;
+        stored_seq  = 0;
+        stored_slot = USER_CONFIG_SLOTS - 1;
+    }
+    user_config = stored;
+    pending     = false;
+    last_event  = timer_read32();
+    writes      = 0;
+    return found;
+}
+
+void user_config_save(void) {
+    pending    = true;
+    last_event = timer_read32();
+}
+
+void user_config_activity(void) {
+    last_event = timer_read32();
+}
+
+void user_config_flush(void) {
+    if (!pending) {
+        return;
+    }
+    pending = false;
+    // Toggled back and forth: nothing to write
+    if (memcmp(&user_config, &stored, sizeof(stored)) == 0) {
+        return;
+    }
+
+    user_config_record_t record = {
+        .seq     = stored_seq + 1,
+        .version = USER_CONFIG_VERSION,
+        .config  = user_config,
+    };
+    record.crc = record_crc(&record);
+
+    uint8_t slot = (stored_slot + 1) % USER_CONFIG_SLOTS;
+    eeprom_update_block(&record, slot_address(slot), sizeof(record));
+    stored      = user_config;
+    stored_seq  = record.seq;
+    stored_slot = slot;
+    writes++;
+}
+
+void user_config_task(void) {
+    if (pending && timer_elapsed32(last_event) >= USER_CONFIG_WRITE_DELAY) {
+        user_config_flush();
+    }
+}
+
+uint32_t user_config_writes(void) {
+    return writes;
+}
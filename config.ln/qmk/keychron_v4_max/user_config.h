@@ -0,0 +1,51 @@
+// Persisted keymap settings in QMK's user EEPROM datablock.
+//
+// The block holds USER_CONFIG_SLOTS records. Each save goes to the slot after the
+// newest one with the next sequence number, so writes rotate over the slots and a
+// write torn by a power loss leaves the previous record intact. At boot the newest
+// record with the right version and CRC wins; with none, the defaults are used.
+//
+// Saves are coalesced: user_config_save() only marks the settings dirty and the
+// write happens from housekeeping once no key has moved for
+// USER_CONFIG_WRITE_DELAY ms, so a burst of brightness steps costs one write and
+// no EEPROM write ever lands between a key press and its report.
+
+#pragma once
+
+#include QMK_KEYBOARD_H
+
+#ifndef USER_CONFIG_SLOTS
+#    define USER_CONFIG_SLOTS 4
+#endif
+#ifndef USER_CONFIG_WRITE_DELAY
+#    define USER_CONFIG_WRITE_DELAY 3000  // ms without key events before a pending save is written
+#endif
+
+#define USER_CONFIG_VERSION 1  // bump when user_config_t changes; older records are ignored
+#define USER_CONFIG_RECORD_SIZE 8
+
+typedef struct {
+    bool    base_rgb_enabled;
+    uint8_t rgb_brightness;
+} user_config_t;
+
+// The live settings. Change them, then call user_config_save().
+extern user_config_t user_config;
+
+// Boot: load the newest valid record. Returns false if there was none (defaults).
+bool user_config_init(void);
+
+// The settings changed; they are written later (see above).
+void user_config_save(void);
+
+// A key event: a pending write waits until the keyboard is quiet again.
+void user_config_activity(void);
+
+// From housekeeping: performs a pending write once quiet.
+void user_config_task(void);
+
+// Performs a pending write now (suspend).
+void user_config_flush(void);
+
+// EEPROM record writes since boot.
+uint32_t user_config_writes(void);